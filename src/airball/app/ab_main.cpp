@@ -5,13 +5,16 @@
 #include "gflags/gflags.h"
 
 #include "../../framework/Application.h"
-#include "../model/IAirballModel.h"
+#include "../model/AirballModel.h"
 #include "../screen/x11_screen.h"
 #include "../model/telemetry/UdpTelemetry.h"
 #include "../model/telemetry/FakeTelemetry.h"
 #include "../model/Airdata.h"
 #include "../view/AirballView.h"
+#include "../view/widgets.h"
+#include "../screen/framebuffer_screen.h"
 #include "../screen/image_screen.h"
+#include "../screen/recording_screen.h"
 #include "../sound_mixer/sound_mixer.h"
 #include "../sound_scheme/airball_sound_scheme.h"
 
@@ -21,13 +24,27 @@
 
 const std::string kScreenX11 = "x11";
 const std::string kScreenImage = "image";
+const std::string kScreenFb = "fb";
 #ifdef AIRBALL_BCM2835
 const std::string kScreenSt7789vi = "st7789vi";
-DEFINE_string(screen, kScreenX11, "Screen implementation (x11, image, st7789vi)");
+DEFINE_string(screen, kScreenX11, "Screen implementation (x11, image, fb, st7789vi)");
 #else
-DEFINE_string(screen, kScreenX11, "Screen implementation (x11, image)");
+DEFINE_string(screen, kScreenX11, "Screen implementation (x11, image, fb)");
 #endif
 
+DEFINE_string(fb_path, "/dev/fb0", "Framebuffer device for the fb screen, or a plain file to paint into");
+DEFINE_bool(fb_wait_for_vsync, true, "Whether the fb screen waits for the vertical blank after each frame");
+DEFINE_int32(fb_file_bits_per_pixel, 16, "Depth of the fb screen when painting into a plain file (16, 32)");
+
+const std::string kImageModePng = "png";
+const std::string kImageModeRaw = "raw";
+DEFINE_string(image_mode, kImageModePng, "How the image screen captures frames (png, raw)");
+DEFINE_string(image_path, "image", "Prefix of the files the image screen captures frames to");
+DEFINE_int32(image_workers, 2, "Number of threads encoding PNG files for the image screen");
+
+DEFINE_string(record_path, "", "Prefix of the files to record the display to, or empty to not record");
+DEFINE_int32(record_keyframe_interval, 300, "Number of frames from one recorded keyframe to the next");
+
 const std::string kTelemetryUdp = "udp";
 const std::string kTelemetryLog = "log";
 const std::string kTelemetryFake = "fake";
@@ -37,35 +54,56 @@ DEFINE_uint32(telemetry_udp_port, 30123, "IP port for UDP telemetry");
 DEFINE_string(telemetry_udp_interface, "wlan0", "Interface for UDP telemetry");
 DEFINE_string(telemetry_log_path, "airball.log", "File path for log telemetry");
 
+const std::string kRenderBackendCairo = "cairo";
+const std::string kRenderBackendRgb565 = "rgb565";
+DEFINE_string(render_backend, kRenderBackendCairo, "Drawing backend for widgets (cairo, rgb565)");
+
+DEFINE_bool(phosphor_trail, false, "Draw the trail of raw airballs as a fading phosphor image");
+
+DEFINE_double(frame_budget_ms, 0, "Time to paint and flush a frame, beyond which the display is drawn at lower quality (0 for always full quality)");
+
 DEFINE_string(sound_device, "hw:0", "ALSA sound device");
 
 DEFINE_string(settings_file_path, "airball-settings.json", "Path to settings file");
 
 DEFINE_string(settings_input_device_path, "", "Path to settings adjustment /dev/input device");
 
+DEFINE_uint32(stage_timing_dump_seconds, 0, "Interval between printing stage timings, if built with AIRBALL_STAGE_TIMING (0 for only on SIGUSR1)");
+
 const auto kFrameInterval = std::chrono::milliseconds(0);
 
 namespace airball {
 
-class AirballModel : public IAirballModel {
-public:
-  AirballModel(IAirdata* airdata, ISettings* settings)
-      : airdata_(airdata), settings_(settings) {}
-
-  [[nodiscard]] const IAirdata* airdata() const override { return airdata_; }
-  [[nodiscard]] const ISettings* settings() const override { return settings_; }
-
-private:
-  IAirdata* airdata_;
-  ISettings* settings_;
-};
+ImageScreen::Mode buildImageMode() {
+  if (FLAGS_image_mode == kImageModePng) {
+    return ImageScreen::Mode::PNG;
+  }
+  if (FLAGS_image_mode == kImageModeRaw) {
+    return ImageScreen::Mode::RAW;
+  }
+  std::cerr << "Unsupported image mode option " << FLAGS_image_mode << std::endl;
+  exit(-1);
+}
 
 std::unique_ptr<IScreen> buildScreen(const ISettings* settings) {
   if (FLAGS_screen == kScreenX11) {
     return std::make_unique<X11Screen>(settings->screen_width(), settings->screen_height());
   }
   if (FLAGS_screen == kScreenImage) {
-    return std::make_unique<ImageScreen>(settings->screen_width(), settings->screen_height());
+    return std::make_unique<ImageScreen>(
+        settings->screen_width(),
+        settings->screen_height(),
+        buildImageMode(),
+        FLAGS_image_path,
+        FLAGS_image_workers);
+  }
+  if (FLAGS_screen == kScreenFb) {
+    return std::make_unique<FramebufferScreen>(
+        FLAGS_fb_path,
+        FLAGS_fb_wait_for_vsync,
+        settings->screen_width(),
+        settings->screen_height(),
+        FLAGS_fb_file_bits_per_pixel);
   }
   #ifdef AIRBALL_BCM2835
   if (FLAGS_screen == kScreenSt7789vi) {
@@ -76,6 +114,36 @@ std::unique_ptr<IScreen> buildScreen(const ISettings* settings) {
   exit(-1);
 }
 
+std::unique_ptr<QualityGovernor> buildQualityGovernor() {
+  if (FLAGS_frame_budget_ms <= 0) {
+    return nullptr;
+  }
+  return std::make_unique<QualityGovernor>(
+      QualityGovernor::Duration(FLAGS_frame_budget_ms),
+      AirballView::LOWEST_QUALITY);
+}
+
+AirballView::Options buildViewOptions(
+    const QualityGovernor* governor,
+    const FrameStats* frameStats) {
+  AirballView::Options options;
+  options.phosphorTrail = FLAGS_phosphor_trail;
+  options.governor = governor;
+  options.frameStats = frameStats;
+  return options;
+}
+
+RenderBackend buildRenderBackend() {
+  if (FLAGS_render_backend == kRenderBackendCairo) {
+    return RenderBackend::CAIRO;
+  }
+  if (FLAGS_render_backend == kRenderBackendRgb565) {
+    return RenderBackend::RGB565;
+  }
+  std::cerr << "Unsupported render backend option " << FLAGS_render_backend << std::endl;
+  exit(-1);
+}
+
 std::unique_ptr<ITelemetry> buildTelemetry() {
   if (FLAGS_telemetry == kTelemetryUdp) {
     return std::make_unique<UdpTelemetry>(FLAGS_telemetry_udp_bcast,
@@ -101,6 +169,10 @@ public:
 protected:
   void initialize() override {
     setFrameInterval(kFrameInterval);
+#ifdef AIRBALL_STAGE_TIMING
+    StageTimers::instance().set_dump_interval(
+        std::chrono::seconds(FLAGS_stage_timing_dump_seconds));
+#endif
     telemetry_ = buildTelemetry();
     settings_ = std::make_unique<Settings>(
         FLAGS_settings_file_path,
@@ -109,12 +181,23 @@ protected:
         [this](ITelemetry::Sample sample) {
           telemetry_->sendSample(sample);
         });
-    setScreen(buildScreen(settings_.get()));
+    std::unique_ptr<IScreen> screen = buildScreen(settings_.get());
+    if (!FLAGS_record_path.empty()) {
+      screen = std::make_unique<RecordingScreen>(
+          std::move(screen),
+          FLAGS_record_path,
+          FLAGS_record_keyframe_interval);
+    }
+    setScreen(std::move(screen));
+    set_render_backend(buildRenderBackend());
     airdata_ = std::make_unique<Airdata>(settings_.get());
     setModel(std::make_unique<AirballModel>(
         airdata_.get(),
-        settings_.get()));
-    setView(std::move(std::make_unique<AirballView>()));
+        settings_.get(),
+        frameStats()));
+    governor_ = buildQualityGovernor();
+    setQualityGovernor(governor_.get());
+    setView(std::move(std::make_unique<AirballView>(buildViewOptions(governor_.get(), frameStats()))));
     setSoundMixer(std::make_unique<sound_mixer>(FLAGS_sound_device));
     setSoundScheme(std::make_unique<airball_sound_scheme>());
 
@@ -122,6 +205,7 @@ protected:
       while (true) {
         ITelemetry::Sample s = telemetry_->receiveSample();
         if (std::holds_alternative<ITelemetry::Airdata>(s)) {
+          frameStats()->count_telemetry();
           eventQueue()->enqueue([this, s]() {
             airdata_->update(std::get<ITelemetry::Airdata>(s));
           });
@@ -144,6 +228,7 @@ private:
   std::unique_ptr<Settings> settings_;
   std::unique_ptr<IAirdata> airdata_;
   std::unique_ptr<ITelemetry> telemetry_;
+  std::unique_ptr<QualityGovernor> governor_;
   std::thread telemetry_read_thread_;
 };
 
@@ -0,0 +1,232 @@
+// Measures how long AirballView takes to paint frames of scripted flight
+// data into an in-memory image, without a display.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+
+#include "../../framework/StageTimers.h"
+
+#include "../model/AirballModel.h"
+#include "../model/Airdata.h"
+#include "../model/FakeSettings.h"
+#include "../screen/memory_screen.h"
+#include "../view/AirballView.h"
+#include "../view/widgets.h"
+
+DEFINE_int32(frames, 600, "Number of frames to paint in each scenario");
+DEFINE_int32(width, 272, "Width of the display, before any rotation");
+DEFINE_int32(height, 480, "Height of the display, before any rotation");
+DEFINE_string(scenario, "all", "Scenario to run (all, nominal, no_altimeter, invalid, rotated, adjusting, no_numeric_airspeed)");
+DEFINE_string(format, "all", "Pixel format of the image (all, argb32, rgb565)");
+DEFINE_bool(phosphor_trail, false, "Draw the trail of raw airballs as a fading phosphor image");
+
+const std::string kRenderBackendCairo = "cairo";
+const std::string kRenderBackendRgb565 = "rgb565";
+DEFINE_string(render_backend, kRenderBackendCairo, "Drawing backend for widgets (cairo, rgb565)");
+
+namespace airball {
+
+// The number of frames in one cycle of the scripted flight data.
+constexpr int kScriptPeriodFrames = 240;
+
+struct Scenario {
+  std::string name;
+  // Whether the flight data is valid.
+  bool valid;
+  std::function<void(FakeSettings::Values&)> configure;
+};
+
+std::vector<Scenario> scenarios() {
+  return {
+      {"nominal", true, [](FakeSettings::Values& v) {}},
+      {"no_altimeter", true, [](FakeSettings::Values& v) {
+        v.show_altimeter = false;
+      }},
+      {"invalid", false, [](FakeSettings::Values& v) {}},
+      {"rotated", true, [](FakeSettings::Values& v) {
+        v.rotate_screen = true;
+      }},
+      {"adjusting", true, [](FakeSettings::Values& v) {
+        v.adjustment_name = "V_FS";
+        v.adjustment_value = "100";
+      }},
+      {"no_numeric_airspeed", true, [](FakeSettings::Values& v) {
+        v.show_numeric_airspeed = false;
+      }},
+  };
+}
+
+struct Format {
+  std::string name;
+  cairo_format_t format;
+};
+
+std::vector<Format> formats() {
+  return {
+      {"argb32", CAIRO_FORMAT_ARGB32},
+      {"rgb565", CAIRO_FORMAT_RGB16_565},
+  };
+}
+
+// Flight data that sweeps the airball around the display, through the
+// airspeed limits, and up and down through some altitude.
+ITelemetry::Airdata scripted_airdata(int frame, bool valid) {
+  const double phase = 2.0 * M_PI * (frame % kScriptPeriodFrames) / kScriptPeriodFrames;
+  return ITelemetry::Airdata {
+      .sequence = (unsigned long) frame,
+      .alpha = valid ? 7.5 + 7.5 * sin(phase) : NAN,
+      .beta = valid ? 5 * sin(2 * phase) : NAN,
+      .q = 720 + 580 * sin(3 * phase),
+      .p = 55000 + 15000 * sin(phase),
+      .t = 10,
+  };
+}
+
+struct Result {
+  double first_ms;
+  double p50_ms;
+  double p99_ms;
+  double max_ms;
+  double fps;
+  // The share of sprites found in the cache, or -1 if none were painted.
+  double sprite_hit_rate;
+};
+
+Result run(const Scenario& scenario, const Format& format) {
+  FakeSettings::Values values;
+  values.screen_width = FLAGS_width;
+  values.screen_height = FLAGS_height;
+  scenario.configure(values);
+  FakeSettings settings(values);
+  Airdata airdata(&settings);
+  AirballModel model(&airdata, &settings);
+  AirballView::Options options;
+  options.phosphorTrail = FLAGS_phosphor_trail;
+  AirballView view(options);
+  // A rotated display is drawn sideways into an image the other way around.
+  MemoryScreen screen(
+      format.format,
+      values.rotate_screen ? values.screen_height : values.screen_width,
+      values.rotate_screen ? values.screen_width : values.screen_height);
+
+  // The first frame builds the layout and the static layers, so it is
+  // reported separately rather than counted with the rest.
+  std::vector<double> ms;
+  double first_ms = 0;
+  for (int i = 0; i <= FLAGS_frames; i++) {
+    airdata.update(scripted_airdata(i, scenario.valid));
+    auto start = std::chrono::steady_clock::now();
+    {
+      AIRBALL_TIME_STAGE("paint");
+      view.paint(model, &screen);
+    }
+    {
+      AIRBALL_TIME_STAGE("screen_flush");
+      screen.flush();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double t = std::chrono::duration<double, std::milli>(end - start).count();
+    if (i == 0) {
+      first_ms = t;
+    } else {
+      ms.push_back(t);
+    }
+  }
+
+  double total_ms = 0;
+  for (double t : ms) {
+    total_ms += t;
+  }
+  std::sort(ms.begin(), ms.end());
+  auto percentile = [&](double p) {
+    return ms[std::min(ms.size() - 1, (size_t) (p * ms.size()))];
+  };
+  const int sprites = view.spriteHits() + view.spriteMisses();
+  return {
+      first_ms,
+      percentile(0.50),
+      percentile(0.99),
+      ms.back(),
+      1000.0 * ms.size() / total_ms,
+      sprites == 0 ? -1 : (double) view.spriteHits() / sprites,
+  };
+}
+
+RenderBackend buildRenderBackend() {
+  if (FLAGS_render_backend == kRenderBackendCairo) {
+    return RenderBackend::CAIRO;
+  }
+  if (FLAGS_render_backend == kRenderBackendRgb565) {
+    return RenderBackend::RGB565;
+  }
+  std::cerr << "Unsupported render backend option " << FLAGS_render_backend << std::endl;
+  exit(-1);
+}
+
+int bench() {
+  if (FLAGS_frames < 1) {
+    std::cerr << "At least one frame is needed" << std::endl;
+    exit(-1);
+  }
+  set_render_backend(buildRenderBackend());
+
+  std::cout << std::left << std::setw(22) << "scenario"
+            << std::setw(8) << "format"
+            << std::right << std::setw(10) << "first ms"
+            << std::setw(10) << "p50 ms"
+            << std::setw(10) << "p99 ms"
+            << std::setw(10) << "max ms"
+            << std::setw(10) << "fps"
+            << std::setw(10) << "sprite %" << std::endl;
+  bool ran = false;
+  for (const auto& s : scenarios()) {
+    if (FLAGS_scenario != "all" && FLAGS_scenario != s.name) {
+      continue;
+    }
+    for (const auto& f : formats()) {
+      if (FLAGS_format != "all" && FLAGS_format != f.name) {
+        continue;
+      }
+      Result r = run(s, f);
+      std::cout << std::left << std::setw(22) << s.name
+                << std::setw(8) << f.name
+                << std::right << std::fixed << std::setprecision(2)
+                << std::setw(10) << r.first_ms
+                << std::setw(10) << r.p50_ms
+                << std::setw(10) << r.p99_ms
+                << std::setw(10) << r.max_ms
+                << std::setprecision(1)
+                << std::setw(10) << r.fps;
+      if (r.sprite_hit_rate < 0) {
+        std::cout << std::setw(10) << "-" << std::endl;
+      } else {
+        std::cout << std::setw(10) << 100 * r.sprite_hit_rate << std::endl;
+      }
+      ran = true;
+    }
+  }
+#ifdef AIRBALL_STAGE_TIMING
+  StageTimers::instance().dump(std::cout);
+#endif
+  if (!ran) {
+    std::cerr << "No scenario " << FLAGS_scenario
+              << " in format " << FLAGS_format << std::endl;
+    exit(-1);
+  }
+  return 0;
+}
+
+}  // namespace airball
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  return airball::bench();
+}
@@ -0,0 +1,397 @@
+// Renders a fixed set of model states and compares them against reference
+// images, to check that changes meant to make drawing faster do not change
+// what is drawn.
+//
+// The reference ("golden") images are drawn with every AirballView option
+// turned off and the Cairo backend, into ARGB32 images, and are written by
+// running with --write_golden. Each state is then drawn with every option
+// turned on, the chosen backend and the chosen pixel format, and compared
+// against its reference, pixel by pixel. A state with no reference image
+// fails. The reference images should be written from a tree from before the
+// change being checked, so that they record what was drawn before it.
+//
+// The time taken to draw each state both ways is reported as well. It is
+// timed over a sequence of frames in which the airdata wanders about the
+// state, as it would in flight, so that nothing is timed only as a repaint
+// of an unchanged frame.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+
+#include "../model/AirballModel.h"
+#include "../model/FakeAirdata.h"
+#include "../model/FakeSettings.h"
+#include "../screen/memory_screen.h"
+#include "../util/units.h"
+#include "../view/AirballView.h"
+#include "../view/widgets.h"
+
+DEFINE_string(golden_dir, "golden", "Directory holding the reference images");
+DEFINE_bool(write_golden, false, "Write the reference images rather than comparing against them");
+DEFINE_string(state, "all", "Model state to render (all, or one name)");
+DEFINE_string(format, "argb32", "Pixel format to render in (argb32, rgb565)");
+DEFINE_int32(tolerance, -1, "Largest difference allowed in any channel, in 8 bit units (-1 for 2 in argb32, 8 in rgb565)");
+DEFINE_int32(max_bad_pixels, 0, "Number of pixels allowed to differ by more than the tolerance");
+DEFINE_int32(iterations, 100, "Number of times to draw each state when timing");
+DEFINE_int32(width, 272, "Width of the display, before any rotation");
+DEFINE_int32(height, 480, "Height of the display, before any rotation");
+
+const std::string kRenderBackendCairo = "cairo";
+const std::string kRenderBackendRgb565 = "rgb565";
+DEFINE_string(render_backend, kRenderBackendCairo, "Drawing backend for widgets (cairo, rgb565)");
+
+namespace airball {
+
+// The number of frames over which the airdata wanders about a state and
+// back again.
+constexpr int kWanderFrames = 60;
+
+struct State {
+  std::string name;
+  std::function<void(FakeSettings::Values&)> configure;
+  // Set the airdata for a frame. Frame 0 is the state itself, as drawn for
+  // the reference image, and later frames wander about it.
+  std::function<void(FakeAirdata&, int frame)> fly;
+};
+
+// How far the airdata has wandered from the state at a frame, from -1 to 1,
+// at one of a few different rates.
+double wander(int frame, int rate) {
+  return sin(2.0 * M_PI * rate * frame / kWanderFrames);
+}
+
+// A trail of raw balls behind the smooth one, as if it had been moving
+// steadily towards where it is now.
+std::vector<IAirdata::Ball> trail(const IAirdata::Ball& ball, double dAlpha, double dBeta) {
+  std::vector<IAirdata::Ball> balls;
+  for (int i = 0; i < 20; i++) {
+    balls.emplace_back(
+        ball.alpha() - i * dAlpha + 0.002 * sin(i),
+        ball.beta() - i * dBeta + 0.002 * cos(i),
+        ball.ias() - 0.1 * i,
+        ball.tas() - 0.1 * i);
+  }
+  return balls;
+}
+
+// Flight with the ball trailing steadily from the given direction, at the
+// given altitude and climb rate.
+std::function<void(FakeAirdata&, int)> steady(
+    const IAirdata::Ball& ball,
+    double dAlpha,
+    double dBeta,
+    double altitude,
+    double climbRate) {
+  return [=](FakeAirdata& a, int frame) {
+    IAirdata::Ball b(
+        ball.alpha() + degrees_to_radians(1) * wander(frame, 1),
+        ball.beta() + degrees_to_radians(1) * wander(frame, 2),
+        ball.ias() * (1 + 0.05 * wander(frame, 3)),
+        ball.tas() * (1 + 0.05 * wander(frame, 3)));
+    a.set_smooth_ball(b);
+    a.set_raw_balls(trail(b, dAlpha, dBeta));
+    a.set_altitude(altitude + 10 * wander(frame, 1));
+    a.set_climb_rate(climbRate + wander(frame, 2));
+  };
+}
+
+const auto cruise =
+    steady(IAirdata::Ball(degrees_to_radians(4), 0, 50, 55), 0.001, 0.0005, 1371.6, 0);
+
+std::vector<State> states() {
+  auto none = [](FakeSettings::Values& v) {};
+  return {
+      {"cruise", none, cruise},
+      {"approach", none, steady(
+          IAirdata::Ball(degrees_to_radians(12), degrees_to_radians(-3), 35, 36),
+          -0.002, 0.001, 91.4, -3.5)},
+      {"below_v_r", none, steady(
+          IAirdata::Ball(degrees_to_radians(8), degrees_to_radians(5), 20, 20.5),
+          0.003, -0.002, 10, 2.5)},
+      {"low_airspeed", none, steady(
+          IAirdata::Ball(degrees_to_radians(2), 0, 1, 1),
+          0, 0, 0, 0)},
+      {"climb", none, steady(
+          IAirdata::Ball(degrees_to_radians(10), degrees_to_radians(1), 40, 46),
+          0.001, 0, 2438.4, 5)},
+      {"invalid", none, [](FakeAirdata& a, int frame) {
+        cruise(a, frame);
+        a.set_valid(false);
+      }},
+      {"no_altimeter", [](FakeSettings::Values& v) {
+        v.show_altimeter = false;
+      }, cruise},
+      {"rotated", [](FakeSettings::Values& v) {
+        v.rotate_screen = true;
+      }, cruise},
+      {"adjusting", [](FakeSettings::Values& v) {
+        v.adjustment_name = "V_FS";
+        v.adjustment_value = "100";
+      }, cruise},
+      {"declutter", [](FakeSettings::Values& v) {
+        v.declutter = true;
+      }, cruise},
+      {"mph", [](FakeSettings::Values& v) {
+        v.speed_units = "mph";
+      }, cruise},
+      {"no_numeric_airspeed", [](FakeSettings::Values& v) {
+        v.show_numeric_airspeed = false;
+      }, cruise},
+  };
+}
+
+// Every way of saving work from one frame to the next turned off.
+AirballView::Options baselineOptions() {
+  AirballView::Options options;
+  options.cacheLayers = false;
+  options.glyphAtlas = false;
+  options.spriteCache = false;
+  options.parallelRegions = false;
+  options.uprightRotation = false;
+  options.displayLists = false;
+  return options;
+}
+
+// A view and the model and screen it draws, set up for one state.
+class Rendering {
+public:
+  Rendering(
+      const State& state,
+      const AirballView::Options& options,
+      cairo_format_t format)
+      : state_(state),
+        settings_(values(state)),
+        model_(&airdata_, &settings_),
+        view_(options),
+        screen_(
+            format,
+            settings_.rotate_screen() ? settings_.screen_height() : settings_.screen_width(),
+            settings_.rotate_screen() ? settings_.screen_width() : settings_.screen_height()) {}
+
+  // Draw a frame of the state, and return the time taken, in milliseconds.
+  double paint(int frame = 0) {
+    state_.fly(airdata_, frame);
+    auto start = std::chrono::steady_clock::now();
+    view_.paint(model_, &screen_);
+    screen_.flush();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+  }
+
+  // The mean time to draw a frame of the state, once everything is set up,
+  // as the airdata wanders about it. The state itself is drawn last, so that
+  // it is what is left in the screen.
+  double time() {
+    paint();
+    double total = 0;
+    for (int i = 0; i < FLAGS_iterations; i++) {
+      total += paint(1 + i % (kWanderFrames - 1));
+    }
+    paint();
+    return total / FLAGS_iterations;
+  }
+
+  cairo_surface_t* cs() const { return screen_.cs(); }
+
+private:
+  static FakeSettings::Values values(const State& state) {
+    FakeSettings::Values v;
+    v.screen_width = FLAGS_width;
+    v.screen_height = FLAGS_height;
+    state.configure(v);
+    return v;
+  }
+
+  const State state_;
+  FakeSettings settings_;
+  FakeAirdata airdata_;
+  AirballModel model_;
+  AirballView view_;
+  MemoryScreen screen_;
+};
+
+// The red, green and blue of a pixel, in 8 bit units.
+void rgb(cairo_surface_t* cs, int x, int y, int c[3]) {
+  const unsigned char* row =
+      cairo_image_surface_get_data(cs) + y * cairo_image_surface_get_stride(cs);
+  if (cairo_image_surface_get_format(cs) == CAIRO_FORMAT_RGB16_565) {
+    const uint16_t p = ((const uint16_t*) row)[x];
+    const int r = p >> 11;
+    const int g = (p >> 5) & 0x3f;
+    const int b = p & 0x1f;
+    c[0] = (r << 3) | (r >> 2);
+    c[1] = (g << 2) | (g >> 4);
+    c[2] = (b << 3) | (b >> 2);
+  } else {
+    const uint32_t p = ((const uint32_t*) row)[x];
+    c[0] = (p >> 16) & 0xff;
+    c[1] = (p >> 8) & 0xff;
+    c[2] = p & 0xff;
+  }
+}
+
+struct Difference {
+  int max;
+  int bad_pixels;
+};
+
+Difference compare(cairo_surface_t* golden, cairo_surface_t* actual, int tolerance) {
+  Difference d = {0, 0};
+  cairo_surface_flush(golden);
+  cairo_surface_flush(actual);
+  const int w = cairo_image_surface_get_width(golden);
+  const int h = cairo_image_surface_get_height(golden);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      int g[3];
+      int a[3];
+      rgb(golden, x, y, g);
+      rgb(actual, x, y, a);
+      int m = 0;
+      for (int i = 0; i < 3; i++) {
+        m = std::max(m, abs(g[i] - a[i]));
+      }
+      d.max = std::max(d.max, m);
+      if (m > tolerance) {
+        d.bad_pixels++;
+      }
+    }
+  }
+  return d;
+}
+
+RenderBackend buildRenderBackend() {
+  if (FLAGS_render_backend == kRenderBackendCairo) {
+    return RenderBackend::CAIRO;
+  }
+  if (FLAGS_render_backend == kRenderBackendRgb565) {
+    return RenderBackend::RGB565;
+  }
+  std::cerr << "Unsupported render backend option " << FLAGS_render_backend << std::endl;
+  exit(-1);
+}
+
+cairo_format_t buildFormat() {
+  if (FLAGS_format == "argb32") {
+    return CAIRO_FORMAT_ARGB32;
+  }
+  if (FLAGS_format == "rgb565") {
+    return CAIRO_FORMAT_RGB16_565;
+  }
+  std::cerr << "Unsupported format option " << FLAGS_format << std::endl;
+  exit(-1);
+}
+
+std::string goldenPath(const State& state) {
+  return FLAGS_golden_dir + "/" + state.name + ".png";
+}
+
+int writeGolden(const std::vector<State>& selected) {
+  set_render_backend(RenderBackend::CAIRO);
+  for (const auto& s : selected) {
+    Rendering r(s, baselineOptions(), CAIRO_FORMAT_ARGB32);
+    r.paint();
+    if (cairo_surface_write_to_png(r.cs(), goldenPath(s).c_str()) != CAIRO_STATUS_SUCCESS) {
+      std::cerr << "Cannot write " << goldenPath(s) << std::endl;
+      return 1;
+    }
+    std::cout << "wrote " << goldenPath(s) << std::endl;
+  }
+  return 0;
+}
+
+int check(const std::vector<State>& selected) {
+  const cairo_format_t format = buildFormat();
+  const RenderBackend backend = buildRenderBackend();
+  const int tolerance =
+      FLAGS_tolerance >= 0 ? FLAGS_tolerance :
+      format == CAIRO_FORMAT_RGB16_565 ? 8 : 2;
+
+  std::cout << std::left << std::setw(22) << "state"
+            << std::right << std::setw(10) << "max diff"
+            << std::setw(12) << "bad pixels"
+            << std::setw(14) << "baseline ms"
+            << std::setw(10) << "ms"
+            << std::setw(10) << "speedup" << std::endl;
+  bool passed = true;
+  for (const auto& s : selected) {
+    cairo_surface_t* golden = cairo_image_surface_create_from_png(goldenPath(s).c_str());
+    if (cairo_surface_status(golden) != CAIRO_STATUS_SUCCESS) {
+      std::cout << std::left << std::setw(22) << s.name
+                << "missing: " << goldenPath(s) << std::endl;
+      cairo_surface_destroy(golden);
+      passed = false;
+      continue;
+    }
+
+    // Each Rendering is timed under its own backend, since the backend is
+    // shared by all views.
+    set_render_backend(RenderBackend::CAIRO);
+    Rendering baseline(s, baselineOptions(), CAIRO_FORMAT_ARGB32);
+    const double baseline_ms = baseline.time();
+
+    set_render_backend(backend);
+    Rendering actual(s, AirballView::Options(), format);
+    const double actual_ms = actual.time();
+
+    if (cairo_image_surface_get_width(golden) != cairo_image_surface_get_width(actual.cs()) ||
+        cairo_image_surface_get_height(golden) != cairo_image_surface_get_height(actual.cs())) {
+      std::cout << std::left << std::setw(22) << s.name
+                << "wrong size: " << goldenPath(s) << std::endl;
+      cairo_surface_destroy(golden);
+      passed = false;
+      continue;
+    }
+
+    const Difference d = compare(golden, actual.cs(), tolerance);
+    cairo_surface_destroy(golden);
+    const bool ok = d.bad_pixels <= FLAGS_max_bad_pixels;
+    if (!ok) {
+      const std::string actualPath = FLAGS_golden_dir + "/" + s.name + "_actual.png";
+      cairo_surface_write_to_png(actual.cs(), actualPath.c_str());
+      passed = false;
+    }
+    std::cout << std::left << std::setw(22) << s.name
+              << std::right << std::setw(10) << d.max
+              << std::setw(12) << d.bad_pixels
+              << std::fixed << std::setprecision(3)
+              << std::setw(14) << baseline_ms
+              << std::setw(10) << actual_ms
+              << std::setprecision(2)
+              << std::setw(9) << baseline_ms / actual_ms << "x"
+              << (ok ? "" : "  FAIL") << std::endl;
+  }
+  std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+  return passed ? 0 : 1;
+}
+
+int run() {
+  std::vector<State> selected;
+  for (const auto& s : states()) {
+    if (FLAGS_state == "all" || FLAGS_state == s.name) {
+      selected.push_back(s);
+    }
+  }
+  if (selected.empty()) {
+    std::cerr << "No state " << FLAGS_state << std::endl;
+    exit(-1);
+  }
+  return FLAGS_write_golden ? writeGolden(selected) : check(selected);
+}
+
+}  // namespace airball
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  return airball::run();
+}
@@ -0,0 +1,38 @@
+#ifndef AIRBALL_MODEL_AIRBALL_MODEL_H
+#define AIRBALL_MODEL_AIRBALL_MODEL_H
+
+#include "../../framework/FrameStats.h"
+#include "IAirballModel.h"
+
+namespace airball {
+
+/**
+ * A model made of airdata and settings owned elsewhere. If given frame stats,
+ * also owned elsewhere, a new summary of them counts as a change while the
+ * settings ask for them to be shown.
+ */
+class AirballModel : public IAirballModel {
+public:
+  AirballModel(IAirdata* airdata, ISettings* settings, const FrameStats* frameStats = nullptr)
+      : airdata_(airdata), settings_(settings), frameStats_(frameStats) {}
+
+  [[nodiscard]] const IAirdata* airdata() const override { return airdata_; }
+  [[nodiscard]] const ISettings* settings() const override { return settings_; }
+
+  [[nodiscard]] Version version() const override {
+    Version v = IAirballModel::version();
+    if (frameStats_ != nullptr && settings_->show_perf_hud()) {
+      v.frameStats = frameStats_->summary().sequence;
+    }
+    return v;
+  }
+
+private:
+  IAirdata* airdata_;
+  ISettings* settings_;
+  const FrameStats* frameStats_;
+};
+
+} // namespace airball
+
+#endif // AIRBALL_MODEL_AIRBALL_MODEL_H
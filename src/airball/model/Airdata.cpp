@@ -12,14 +12,35 @@ constexpr double kSamplesPerSecond = 20;
 constexpr static std::chrono::milliseconds
     kAirdataExpiryPeriod(250);
 
+// How far past the last sample the smooth ball may be carried on, which is
+// the time until the next sample is due.
+constexpr static std::chrono::milliseconds
+    kExtrapolationHorizon(50);
+
+// The horizon is divided into steps, each of which changes the version so
+// that a frame is painted for it. They are a little shorter than the frames
+// of a 60 Hz display.
+constexpr static unsigned long kExtrapolationSteps = 4;
+
+// The smooth ball is only extrapolated from samples that arrived this far
+// apart. Closer together, the velocity between them is mostly noise; further
+// apart, samples have been lost and the velocity is stale.
+constexpr static std::chrono::milliseconds
+    kMinExtrapolationInterval(10);
+constexpr static std::chrono::milliseconds
+    kMaxExtrapolationInterval(150);
+
 Airdata::Airdata(ISettings* settings)
     : settings_(settings),
       climb_rate_filter_(1),
       valid_(true),
+      update_count_(0),
       raw_balls_(kNumBalls),
       altitude_(0),
       climb_rate_(0) { }
 
+Airdata::~Airdata() = default;
+
 static double
 smooth(double current_value, double new_value, double time_constant) {
   double sample_time = 1.0 / kSamplesPerSecond;
@@ -61,16 +82,14 @@ void Airdata::update(
   new_ias = isnan(new_ias) ? smooth_ball_.ias() : new_ias;
   new_tas = isnan(new_tas) ? smooth_ball_.tas() : new_tas;
 
+  previous_smooth_ball_ = smooth_ball_;
   smooth_ball_ = Ball(
       smooth(smooth_ball_.alpha(), alpha, ball_time_constant),
       smooth(smooth_ball_.beta(), beta, ball_time_constant),
       smooth(smooth_ball_.ias(), new_ias, ball_time_constant),
       smooth(smooth_ball_.tas(), new_tas, ball_time_constant));
 
-  for (size_t i = raw_balls_.size() - 1; i > 0; i--) {
-    raw_balls_[i] = raw_balls_[i - 1];
-  }
-  raw_balls_[0] = Ball(new_alpha, new_beta, new_ias, new_tas);
+  raw_balls_.push(Ball(new_alpha, new_beta, new_ias, new_tas));
 
   pressure_altitude_ = pressure_to_altitude(t, p, QNH_STANDARD);
 
@@ -85,13 +104,67 @@ void Airdata::update(
   altitude_ = pressure_to_altitude(t, p, qnh);
 
   valid_ = !isnan(alpha) && !isnan(beta);
-  lastUpdateTime_ = std::chrono::system_clock::now();
+  previousUpdateTime_ = lastUpdateTime_;
+  lastUpdateTime_ = std::chrono::steady_clock::now();
+  update_count_++;
 }
 
 bool Airdata::valid() const {
   return
       valid_ &&
-      (std::chrono::system_clock::now() - lastUpdateTime_) < kAirdataExpiryPeriod;
+      (std::chrono::steady_clock::now() - lastUpdateTime_) < kAirdataExpiryPeriod;
+}
+
+static double extrapolate(double previous, double current, double fraction) {
+  return current + (current - previous) * fraction;
+}
+
+bool Airdata::extrapolating() const {
+  if (update_count_ < 2) {
+    return false;
+  }
+  const auto interval = lastUpdateTime_ - previousUpdateTime_;
+  return interval >= kMinExtrapolationInterval &&
+         interval <= kMaxExtrapolationInterval;
+}
+
+IAirdata::Ball Airdata::smooth_ball_at(std::chrono::steady_clock::time_point t) const {
+  if (!extrapolating()) {
+    return smooth_ball_;
+  }
+  const auto ahead = std::clamp<std::chrono::steady_clock::duration>(
+      t - lastUpdateTime_,
+      std::chrono::steady_clock::duration::zero(),
+      kExtrapolationHorizon);
+  // The smooth ball moved from previous_smooth_ball_ to smooth_ball_ in the
+  // time between the last two updates.
+  const double fraction =
+      std::chrono::duration<double>(ahead).count() /
+      std::chrono::duration<double>(lastUpdateTime_ - previousUpdateTime_).count();
+  return Ball(
+      extrapolate(previous_smooth_ball_.alpha(), smooth_ball_.alpha(), fraction),
+      extrapolate(previous_smooth_ball_.beta(), smooth_ball_.beta(), fraction),
+      extrapolate(previous_smooth_ball_.ias(), smooth_ball_.ias(), fraction),
+      extrapolate(previous_smooth_ball_.tas(), smooth_ball_.tas(), fraction));
+}
+
+unsigned long Airdata::extrapolation_step() const {
+  if (!extrapolating()) {
+    return 0;
+  }
+  const auto since = std::chrono::steady_clock::now() - lastUpdateTime_;
+  return std::min<unsigned long>(
+      kExtrapolationSteps,
+      since * kExtrapolationSteps / kExtrapolationHorizon);
+}
+
+unsigned long Airdata::version() const {
+  // Expiry can only make valid() go from true to false between updates, so
+  // counting it as a half step keeps the version increasing. Between
+  // updates, smooth_ball_at() also moves on through the steps of the
+  // extrapolation horizon, each of which counts as a change.
+  return 2 * (update_count_ * (kExtrapolationSteps + 1) + extrapolation_step()) +
+         (valid() ? 0 : 1);
 }
 
 } // namespace airball
@@ -22,7 +22,9 @@ public:
   [[nodiscard]] double altitude() const override { return altitude_; }
   [[nodiscard]] double climb_rate() const override { return climb_rate_; }
   [[nodiscard]] const Ball& smooth_ball() const override { return smooth_ball_; }
-  [[nodiscard]] const std::vector<Ball>& raw_balls() const override { return raw_balls_; }
+  [[nodiscard]] const BallHistory& raw_balls() const override { return raw_balls_; }
+  [[nodiscard]] Ball smooth_ball_at(std::chrono::steady_clock::time_point t) const override;
+  [[nodiscard]] unsigned long version() const override;
 
   void update(ITelemetry::Airdata sample) override;
 
@@ -37,16 +39,29 @@ private:
       double ball_time_constant,
       double vsi_time_constant);
 
+  // Whether the last two updates were far enough apart, and close enough
+  // together, for the smooth ball to be carried on past the last one.
+  [[nodiscard]] bool extrapolating() const;
+
+  // How many of the steps through the extrapolation horizon have passed
+  // since the last update.
+  [[nodiscard]] unsigned long extrapolation_step() const;
+
   static constexpr int kSlineReaderamplesPerSecond = 20;
   static constexpr uint kNumBalls = 20;
 
   ISettings* settings_;
 
   bool valid_;
-  std::chrono::system_clock::time_point lastUpdateTime_;
+  std::chrono::steady_clock::time_point lastUpdateTime_;
+  // The time of the update before the last.
+  std::chrono::steady_clock::time_point previousUpdateTime_;
+  unsigned long update_count_;
 
   Ball smooth_ball_;
-  std::vector<Ball> raw_balls_;
+  // The smooth ball before the last update.
+  Ball previous_smooth_ball_;
+  BallHistory raw_balls_;
 
   LinearRateFilter climb_rate_filter_;
   double climb_rate_;
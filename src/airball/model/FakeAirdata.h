@@ -0,0 +1,51 @@
+#ifndef AIRBALL_MODEL_FAKE_AIRDATA_H
+#define AIRBALL_MODEL_FAKE_AIRDATA_H
+
+#include "IAirdata.h"
+
+namespace airball {
+
+/**
+ * Airdata whose values are set directly, rather than computed from
+ * telemetry, for driving the view with exactly known values.
+ */
+class FakeAirdata : public IAirdata {
+public:
+  FakeAirdata()
+      : valid_(true), altitude_(0), climb_rate_(0), version_(0) {}
+
+  // Telemetry is ignored.
+  void update(ITelemetry::Airdata sample) override {}
+
+  [[nodiscard]] double altitude() const override { return altitude_; }
+  [[nodiscard]] double climb_rate() const override { return climb_rate_; }
+  [[nodiscard]] bool valid() const override { return valid_; }
+  [[nodiscard]] const Ball& smooth_ball() const override { return smooth_ball_; }
+  [[nodiscard]] const BallHistory& raw_balls() const override { return raw_balls_; }
+  // Stands still between samples.
+  [[nodiscard]] Ball smooth_ball_at(std::chrono::steady_clock::time_point t) const override {
+    return smooth_ball_;
+  }
+  [[nodiscard]] unsigned long version() const override { return version_; }
+
+  void set_valid(bool valid) { valid_ = valid; version_++; }
+  // Meters.
+  void set_altitude(double altitude) { altitude_ = altitude; version_++; }
+  // Meters per second.
+  void set_climb_rate(double climb_rate) { climb_rate_ = climb_rate; version_++; }
+  void set_smooth_ball(const Ball& ball) { smooth_ball_ = ball; version_++; }
+  // Most recent first.
+  void set_raw_balls(const std::vector<Ball>& balls) { raw_balls_ = BallHistory(balls); version_++; }
+
+private:
+  bool valid_;
+  double altitude_;
+  double climb_rate_;
+  Ball smooth_ball_;
+  BallHistory raw_balls_;
+  unsigned long version_;
+};
+
+} // namespace airball
+
+#endif // AIRBALL_MODEL_FAKE_AIRDATA_H
@@ -0,0 +1,109 @@
+#ifndef AIRBALL_MODEL_FAKE_SETTINGS_H
+#define AIRBALL_MODEL_FAKE_SETTINGS_H
+
+#include "ISettings.h"
+
+namespace airball {
+
+/**
+ * Settings held in memory, for driving the view without a settings file or
+ * an adjustment knob. The defaults are the same as those of Settings.
+ */
+class FakeSettings : public ISettings {
+public:
+  struct Values {
+    double ias_full_scale = 100;
+    double v_r = 50;
+    double v_fe = 75;
+    double v_no = 100;
+    double v_ne = 100;
+    double alpha_stall = 15;
+    double alpha_stall_warning = 14;
+    double alpha_min = -10;
+    double alpha_max = 20;
+    double alpha_x = 12;
+    double alpha_y = 10;
+    double alpha_ref = 14;
+    double beta_full_scale = 20;
+    double beta_bias = 0;
+    double baro_setting = 29.92;
+    double ball_time_constant = 0.5;
+    double vsi_time_constant = 1.0;
+    int screen_width = 272;
+    int screen_height = 480;
+    bool show_altimeter = true;
+    bool show_link_status = true;
+    bool show_probe_battery_status = true;
+    bool declutter = false;
+    std::string sound_scheme = "stallfence";
+    double audio_volume = 1.0;
+    std::string speed_units = "knots";
+    bool rotate_screen = false;
+    double screen_brightness = 1.0;
+    bool show_numeric_airspeed = true;
+    double q_correction_factor = 1.0;
+    bool show_perf_hud = false;
+    // The parameter being adjusted, or empty if not adjusting.
+    std::string adjustment_name;
+    std::string adjustment_value;
+  };
+
+  FakeSettings() : generation_(0) {}
+  explicit FakeSettings(const Values& values)
+      : values_(values), generation_(0) {}
+
+  const Values& values() const { return values_; }
+
+  // Replace all the values, which counts as a change to the settings.
+  void set(const Values& values) {
+    values_ = values;
+    generation_++;
+  }
+
+  double ias_full_scale() const override { return values_.ias_full_scale; }
+  double v_r() const override { return values_.v_r; }
+  double v_fe() const override { return values_.v_fe; }
+  double v_no() const override { return values_.v_no; }
+  double v_ne() const override { return values_.v_ne; }
+  double alpha_stall() const override { return values_.alpha_stall; }
+  double alpha_stall_warning() const override { return values_.alpha_stall_warning; }
+  double alpha_min() const override { return values_.alpha_min; }
+  double alpha_max() const override { return values_.alpha_max; }
+  double alpha_x() const override { return values_.alpha_x; }
+  double alpha_y() const override { return values_.alpha_y; }
+  double alpha_ref() const override { return values_.alpha_ref; }
+  double beta_full_scale() const override { return values_.beta_full_scale; }
+  double beta_bias() const override { return values_.beta_bias; }
+  double baro_setting() const override { return values_.baro_setting; }
+  double ball_time_constant() const override { return values_.ball_time_constant; }
+  double vsi_time_constant() const override { return values_.vsi_time_constant; }
+  int screen_width() const override { return values_.screen_width; }
+  int screen_height() const override { return values_.screen_height; }
+  bool show_altimeter() const override { return values_.show_altimeter; }
+  bool show_link_status() const override { return values_.show_link_status; }
+  bool show_probe_battery_status() const override { return values_.show_probe_battery_status; }
+  bool declutter() const override { return values_.declutter; }
+  std::string sound_scheme() const override { return values_.sound_scheme; }
+  double audio_volume() const override { return values_.audio_volume; }
+  std::string speed_units() const override { return values_.speed_units; }
+  bool rotate_screen() const override { return values_.rotate_screen; }
+  double screen_brightness() const override { return values_.screen_brightness; }
+  bool show_numeric_airspeed() const override { return values_.show_numeric_airspeed; }
+  double q_correction_factor() const override { return values_.q_correction_factor; }
+  bool show_perf_hud() const override { return values_.show_perf_hud; }
+
+  bool adjusting() const override { return !values_.adjustment_name.empty(); }
+
+  unsigned long generation() const override { return generation_; }
+
+  std::string adjustmentDisplayName() const override { return values_.adjustment_name; }
+  std::string adjustmentDisplayValue() const override { return values_.adjustment_value; }
+
+private:
+  Values values_;
+  unsigned long generation_;
+};
+
+} // namespace airball
+
+#endif // AIRBALL_MODEL_FAKE_SETTINGS_H
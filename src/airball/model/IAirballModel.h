@@ -10,6 +10,29 @@ class IAirballModel {
 public:
   virtual const IAirdata* airdata() const = 0;
   virtual const ISettings* settings() const = 0;
+
+  /**
+   * The versions of each part of the model. They are compared part by part,
+   * rather than combined into one number, so that a change to one part can
+   * never be cancelled out by a change to another.
+   */
+  struct Version {
+    unsigned long airdata = 0;
+    unsigned long settings = 0;
+    // The frame statistics summary being displayed, if any.
+    unsigned long frameStats = 0;
+
+    bool operator==(const Version&) const = default;
+  };
+
+  /**
+   * @return a version that changes whenever the airdata or the settings
+   * change. A frame painted from a model with the same version as a previous
+   * frame would be identical to it.
+   */
+  virtual Version version() const {
+    return {airdata()->version(), settings()->generation()};
+  }
 };
 
 } // namespace airball
@@ -1,6 +1,8 @@
 #ifndef AIRBALL_APP_IAIRDATA_H
 #define AIRBALL_APP_IAIRDATA_H
 
+#include <algorithm>
+#include <chrono>
 #include <vector>
 
 #include "telemetry/ITelemetry.h"
@@ -27,13 +29,79 @@ public:
     double tas_;
   };
 
+  /**
+   * A history of balls, most recent first, kept as an array per value so
+   * that the whole history can be transformed in one pass.
+   */
+  class BallHistory {
+  public:
+    explicit BallHistory(size_t size = 0)
+        : alpha_(size), beta_(size), ias_(size), tas_(size) {}
+    explicit BallHistory(const std::vector<Ball>& balls)
+        : BallHistory(balls.size()) {
+      for (size_t i = 0; i < balls.size(); i++) {
+        set(i, balls[i]);
+      }
+    }
+
+    size_t size() const { return alpha_.size(); }
+    bool empty() const { return alpha_.empty(); }
+    Ball operator[](size_t i) const {
+      return Ball(alpha_[i], beta_[i], ias_[i], tas_[i]);
+    }
+
+    const float* alpha() const { return alpha_.data(); }
+    const float* beta() const { return beta_.data(); }
+    const float* ias() const { return ias_.data(); }
+    const float* tas() const { return tas_.data(); }
+
+    // Add a ball as the most recent, forgetting the oldest.
+    void push(const Ball& ball) {
+      if (empty()) {
+        return;
+      }
+      for (auto* v : {&alpha_, &beta_, &ias_, &tas_}) {
+        std::copy_backward(v->begin(), v->end() - 1, v->end());
+      }
+      set(0, ball);
+    }
+
+  private:
+    void set(size_t i, const Ball& ball) {
+      alpha_[i] = (float) ball.alpha();
+      beta_[i] = (float) ball.beta();
+      ias_[i] = (float) ball.ias();
+      tas_[i] = (float) ball.tas();
+    }
+
+    std::vector<float> alpha_;
+    std::vector<float> beta_;
+    std::vector<float> ias_;
+    std::vector<float> tas_;
+  };
+
   virtual void update(ITelemetry::Airdata sample) = 0;
 
   virtual double altitude() const = 0;
   virtual double climb_rate() const = 0;
   virtual bool valid() const = 0;
   virtual const Ball& smooth_ball() const = 0;
-  virtual const std::vector<Ball>& raw_balls() const = 0;
+  virtual const BallHistory& raw_balls() const = 0;
+
+  /**
+   * @return the smooth ball carried on from the last sample to the given
+   * time, along the way it moved from the sample before, for drawing at a
+   * higher rate than samples arrive. It is carried on no further than a
+   * short horizon after the last sample, and is never earlier than it.
+   */
+  virtual Ball smooth_ball_at(std::chrono::steady_clock::time_point t) const = 0;
+
+  /**
+   * @return a number that increases whenever any of the values above changes,
+   * including when valid() changes because the data has expired. Clients may
+   * use this to tell whether anything has changed since they last looked.
+   */
+  virtual unsigned long version() const = 0;
 };
 
 } // namespace airball
@@ -157,8 +157,20 @@ public:
    */
   virtual double q_correction_factor() const = 0;
 
+  /**
+   * @return whether to display how quickly frames are being painted.
+   */
+  virtual bool show_perf_hud() const = 0;
+
   virtual bool adjusting() const = 0;
 
+  /**
+   * @return a number that changes whenever any of the settings, including the
+   * adjustment state, changes. Clients may use this to cache values derived
+   * from the settings.
+   */
+  virtual unsigned long generation() const = 0;
+
   virtual std::string adjustmentDisplayName() const = 0;
   virtual std::string adjustmentDisplayValue() const = 0;
 };
@@ -144,7 +144,8 @@ Settings::Settings(const std::string& settingsFilePath,
       loadedFromFile_(false),
       currentAdjustingVector_(nullptr),
       currentAdjustingIndex_(0),
-      adjustmentKnobState_(UNKNOWN) {
+      adjustmentKnobState_(UNKNOWN),
+      generation_(0) {
   settingsEventSource_ = std::make_unique<SettingsEventSource>(
           settingsFilePath,
           inputDevicePath,
@@ -185,6 +186,7 @@ void Settings::buildParamsVectors() {
     &store_->SOUND_SCHEME,
     &store_->SPEED_UNITS,
     &store_->Q_CORRECTION_FACTOR,
+    &store_->SHOW_PERF_HUD,
   };
 }
 
@@ -261,6 +263,7 @@ void Settings::loadFromString(std::string s) {
   for (Parameter *p : store_->ALL_PARAMS) {
     p->load(d);
   }
+  changed();
 }
 
 std::string Settings::saveToString() {
@@ -403,10 +406,22 @@ double Settings::q_correction_factor() const {
   return store_->Q_CORRECTION_FACTOR.get();
 }
 
+bool Settings::show_perf_hud() const {
+  return store_->SHOW_PERF_HUD.get();
+}
+
 bool Settings::adjusting() const {
   return (currentAdjustingVector_ != nullptr);
 }
 
+unsigned long Settings::generation() const {
+  return generation_;
+}
+
+void Settings::changed() {
+  generation_++;
+}
+
 std::string Settings::adjustmentDisplayName() const  {
   if (currentAdjustingVector_ == nullptr) {
     return "";
@@ -425,6 +440,7 @@ void Settings::startAdjustingShallow() {
   if (currentAdjustingVector_ == nullptr) {
     currentAdjustingVector_ = &adjustmentParamsShallow_;
     currentAdjustingIndex_ = 0;
+    changed();
   }
 }
 
@@ -433,12 +449,14 @@ void Settings::nextAdjustment() {
     startAdjustingShallow();
   } else {
     currentAdjustingIndex_ = (currentAdjustingIndex_ + 1) % currentAdjustingVector_->size();
+    changed();
   }
 }
 
 void Settings::hidIncrement() {
   startAdjustingShallow();
   (*currentAdjustingVector_)[currentAdjustingIndex_]->increment();
+  changed();
   saveToFile();
   maybeSendSettings();
 }
@@ -446,6 +464,7 @@ void Settings::hidIncrement() {
 void Settings::hidDecrement() {
   startAdjustingShallow();
   (*currentAdjustingVector_)[currentAdjustingIndex_]->decrement();
+  changed();
   saveToFile();
   maybeSendSettings();  
 }
@@ -460,6 +479,7 @@ void Settings::hidCancelTimerFired() {
   if (currentAdjustingVector_ == &adjustmentParamsShallow_) {
     currentAdjustingVector_ = nullptr;
     currentAdjustingIndex_ = 0;
+    changed();
   }
 }
 
@@ -467,9 +487,11 @@ void Settings::hidLongPressTimerFired() {
   if (currentAdjustingVector_ == nullptr || currentAdjustingVector_ == &adjustmentParamsShallow_) {
     currentAdjustingVector_ = &adjustmentParamsDeep_;
     currentAdjustingIndex_ = 0;
+    changed();
   } else if (currentAdjustingVector_ == &adjustmentParamsDeep_) {
     currentAdjustingVector_ = &adjustmentParamsShallow_;
     currentAdjustingIndex_ = 0;
+    changed();
   }
 }
 
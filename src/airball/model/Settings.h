@@ -52,9 +52,12 @@ public:
   double screen_brightness() const override;
   bool show_numeric_airspeed() const override;
   double q_correction_factor() const override;
+  bool show_perf_hud() const override;
 
   bool adjusting() const override;
 
+  unsigned long generation() const override;
+
   std::string adjustmentDisplayName() const override;
   std::string adjustmentDisplayValue() const override;
 
@@ -90,6 +93,8 @@ private:
 
   void buildParamsVectors();
 
+  void changed();
+
   std::string path_;
   std::function<void(ITelemetry::Sample)> sendSample_;
   bool loadedFromFile_;
@@ -102,6 +107,8 @@ private:
   size_t currentAdjustingIndex_;
 
   AdjustmentKnobState adjustmentKnobState_;
+
+  unsigned long generation_;
 };
 
 } // namespace airball
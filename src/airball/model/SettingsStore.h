@@ -469,6 +469,11 @@ public:
       0.5, 1.5, 0.05,
       "%4.2f",
   };
+  BoolParameter SHOW_PERF_HUD {
+      "show_perf_hud",
+      "PERF?",
+      false,
+  };
   
   const std::vector<Parameter *> ALL_PARAMS = {
       (Parameter*) &IAS_FULL_SCALE,
@@ -501,6 +506,7 @@ public:
       (Parameter*) &SCREEN_BRIGHTNESS,
       (Parameter*) &SHOW_NUMERIC_AIRSPEED,
       (Parameter*) &Q_CORRECTION_FACTOR,
+      (Parameter*) &SHOW_PERF_HUD,
   };
 };
 
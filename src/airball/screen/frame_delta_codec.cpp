@@ -0,0 +1,105 @@
+#include "frame_delta_codec.h"
+
+#include <cstring>
+
+namespace airball {
+
+namespace frame_delta_codec {
+
+static void put_varint(size_t value, std::vector<uint8_t>& out) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t) (value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t) value);
+}
+
+static bool get_varint(const uint8_t*& p, const uint8_t* end, size_t& value) {
+  value = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    const uint8_t b = *p++;
+    value |= (size_t) (b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void put_word(uint32_t w, std::vector<uint8_t>& out) {
+  out.push_back((uint8_t) w);
+  out.push_back((uint8_t) (w >> 8));
+  out.push_back((uint8_t) (w >> 16));
+  out.push_back((uint8_t) (w >> 24));
+}
+
+static uint32_t get_word(const uint8_t* p) {
+  return
+      (uint32_t) p[0] |
+      (uint32_t) p[1] << 8 |
+      (uint32_t) p[2] << 16 |
+      (uint32_t) p[3] << 24;
+}
+
+void encode(
+    const uint32_t* frame,
+    const uint32_t* previous,
+    size_t words,
+    std::vector<uint8_t>& out) {
+  auto delta = [&](size_t i) {
+    return previous == nullptr ? frame[i] : frame[i] ^ previous[i];
+  };
+  size_t i = 0;
+  while (i < words) {
+    size_t zeros_start = i;
+    while (i < words && delta(i) == 0) {
+      i++;
+    }
+    // A single zero word costs less to include in a literal run than to
+    // start a new run with, so literal runs end at two zero words in a row.
+    size_t literal_start = i;
+    while (i < words &&
+           (delta(i) != 0 || (i + 1 < words && delta(i + 1) != 0))) {
+      i++;
+    }
+    put_varint(literal_start - zeros_start, out);
+    put_varint(i - literal_start, out);
+    for (size_t j = literal_start; j < i; j++) {
+      put_word(delta(j), out);
+    }
+  }
+}
+
+bool decode(
+    const uint8_t* data,
+    size_t size,
+    bool keyframe,
+    uint32_t* frame,
+    size_t words) {
+  if (keyframe) {
+    memset(frame, 0, words * sizeof(uint32_t));
+  }
+  const uint8_t* p = data;
+  const uint8_t* end = data + size;
+  size_t i = 0;
+  while (p < end) {
+    size_t zeros;
+    size_t literals;
+    if (!get_varint(p, end, zeros) ||
+        !get_varint(p, end, literals) ||
+        zeros > words - i ||
+        literals > words - i - zeros ||
+        literals > (size_t) (end - p) / 4) {
+      return false;
+    }
+    i += zeros;
+    for (size_t j = 0; j < literals; j++, i++, p += 4) {
+      frame[i] ^= get_word(p);
+    }
+  }
+  return i == words;
+}
+
+}  // namespace frame_delta_codec
+
+}  // namespace airball
@@ -0,0 +1,64 @@
+#ifndef AIRBALL_SCREEN_FRAME_DELTA_CODEC_H
+#define AIRBALL_SCREEN_FRAME_DELTA_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace airball {
+
+/**
+ * Encodes frames as the difference from the frame before, for recording
+ * displays whose frames mostly do not change from one to the next.
+ *
+ * A frame is treated as an array of 32 bit words. Each word is XORed with
+ * the same word of the previous frame, or with zero for a keyframe, which
+ * stands alone. The result, mostly zero, is stored as a sequence of runs,
+ * each of which is:
+ *
+ *   - the number of zero words, as a varint;
+ *   - the number of words that follow, as a varint;
+ *   - those words, little endian.
+ *
+ * Varints are unsigned LEB128: 7 bits per byte, least significant first, with
+ * the top bit set on all bytes but the last.
+ */
+namespace frame_delta_codec {
+
+/**
+ * Append the encoding of a frame to a buffer.
+ *
+ * @param frame the frame.
+ * @param previous the previous frame, or nullptr to encode a keyframe.
+ * @param words the number of words in each frame.
+ * @param out the buffer to append to.
+ */
+void encode(
+    const uint32_t* frame,
+    const uint32_t* previous,
+    size_t words,
+    std::vector<uint8_t>& out);
+
+/**
+ * Decode a frame.
+ *
+ * @param data the encoding of the frame.
+ * @param size the number of bytes in the encoding.
+ * @param keyframe whether the frame was encoded as a keyframe.
+ * @param frame on entry, the previous frame, unless this is a keyframe; on
+ *     exit, the frame.
+ * @param words the number of words in each frame.
+ * @return whether the encoding was well formed and covered the whole frame.
+ */
+bool decode(
+    const uint8_t* data,
+    size_t size,
+    bool keyframe,
+    uint32_t* frame,
+    size_t words);
+
+}  // namespace frame_delta_codec
+
+}  // namespace airball
+
+#endif  // AIRBALL_SCREEN_FRAME_DELTA_CODEC_H
@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "frame_delta_codec.h"
+
+#define ASSERT_TRUE(x) if (!(x)) { std::cout << "Assertion failed " << __FILE__ << ":" << __LINE__ << std::endl; }
+
+using namespace airball;
+
+constexpr size_t kWords = 1000;
+
+// Encodes a sequence of frames, decodes them, and checks that they come back
+// unchanged. Returns the total size of the encodings.
+size_t round_trip(const std::vector<std::vector<uint32_t>>& frames, int keyframe_interval) {
+  std::vector<uint32_t> decoded(kWords, 0xdeadbeef);
+  size_t total = 0;
+  for (size_t i = 0; i < frames.size(); i++) {
+    const bool keyframe = i % keyframe_interval == 0;
+    std::vector<uint8_t> encoded;
+    frame_delta_codec::encode(
+        frames[i].data(),
+        keyframe ? nullptr : frames[i - 1].data(),
+        kWords,
+        encoded);
+    total += encoded.size();
+    ASSERT_TRUE(frame_delta_codec::decode(
+        encoded.data(), encoded.size(), keyframe, decoded.data(), kWords));
+    ASSERT_TRUE(decoded == frames[i]);
+  }
+  return total;
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::vector<uint32_t>> frames;
+
+  // A static frame with a small moving region, like the display.
+  std::vector<uint32_t> f(kWords, 0xff000000);
+  for (int i = 0; i < 20; i++) {
+    for (int j = 0; j < 10; j++) {
+      f[(i * 37 + j) % kWords] = 0xffffffff - i;
+    }
+    frames.push_back(f);
+  }
+  // Isolated changes and changes at either end.
+  f[0] = 1;
+  f[2] = 2;
+  f[kWords - 1] = 3;
+  frames.push_back(f);
+  // No change at all.
+  frames.push_back(f);
+  // Everything changes.
+  for (size_t i = 0; i < kWords; i++) {
+    f[i] = rand();
+  }
+  frames.push_back(f);
+
+  const size_t keyed = round_trip(frames, 1);
+  const size_t delta = round_trip(frames, 10);
+  ASSERT_TRUE(delta < keyed);
+
+  // An unchanged frame takes a couple of bytes.
+  std::vector<uint8_t> encoded;
+  frame_delta_codec::encode(f.data(), f.data(), kWords, encoded);
+  ASSERT_TRUE(encoded.size() <= 4);
+
+  // Malformed encodings are rejected.
+  std::vector<uint32_t> decoded(kWords);
+  const uint8_t too_long[] = {0x80, 0x80, 0x01, 0x00};
+  ASSERT_TRUE(!frame_delta_codec::decode(too_long, sizeof(too_long), true, decoded.data(), kWords));
+  const uint8_t too_short[] = {0x10, 0x00};
+  ASSERT_TRUE(!frame_delta_codec::decode(too_short, sizeof(too_short), true, decoded.data(), kWords));
+  const uint8_t truncated[] = {0x00, 0x02, 0x01, 0x02, 0x03, 0x04};
+  ASSERT_TRUE(!frame_delta_codec::decode(truncated, sizeof(truncated), true, decoded.data(), kWords));
+}
@@ -1,7 +1,10 @@
 #include "framebuffer_screen.h"
 
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
 #include <fcntl.h>
-#include <linux/fb.h>
+#include <iostream>
 #include <linux/kd.h>
 #include <stdio.h>
 #include <sys/mman.h>
@@ -11,64 +14,230 @@
 
 namespace airball {
 
-FramebufferScreen::FramebufferScreen() {
-  setUpFb();
-  cs_ = cairo_image_surface_create_for_data(
-      fbp_,
-      CAIRO_FORMAT_ARGB32,
-      xres_,
-      yres_,
-      cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, xres_));
-  cr_ = cairo_create(cs_);
+FramebufferScreen::FramebufferScreen(
+    const std::string& path,
+    bool wait_for_vsync,
+    int file_width,
+    int file_height,
+    int file_bits_per_pixel)
+    : path_(path),
+      wait_for_vsync_(wait_for_vsync),
+      is_device_(false),
+      fbfd_(-1),
+      fbp_(nullptr),
+      screensize_(0),
+      vinfo_({}),
+      xres_(0),
+      yres_(0),
+      line_length_(0),
+      format_(CAIRO_FORMAT_INVALID),
+      num_pages_(1),
+      drawing_(0),
+      back_buffer_(nullptr),
+      page_cs_{nullptr, nullptr},
+      page_cr_{nullptr, nullptr} {
+  // Open the file for reading and writing
+  fbfd_ = open(path_.c_str(), O_RDWR);
+  if (fbfd_ == -1) {
+    perror("Error: cannot open framebuffer device");
+    exit(1);
+  }
+
+  struct fb_fix_screeninfo finfo;
+  is_device_ = ioctl(fbfd_, FBIOGET_FSCREENINFO, &finfo) != -1;
+  if (is_device_) {
+    setUpDevice();
+  } else if (errno == ENOTTY) {
+    setUpFile(file_width, file_height, file_bits_per_pixel);
+  } else {
+    perror("Error reading fixed information");
+    exit(2);
+  }
+  setUpSurfaces();
+  select(num_pages_ == 2 ? 1 : 0);
 }
 
 FramebufferScreen::~FramebufferScreen() {
-  cairo_destroy(cr_);
-  cairo_surface_destroy(cs_);
+  for (int i = 0; i < 2; i++) {
+    if (page_cr_[i] != nullptr) {
+      cairo_destroy(page_cr_[i]);
+      cairo_surface_destroy(page_cs_[i]);
+    }
+  }
+  free(back_buffer_);
   tearDownFb();
 }
 
-void FramebufferScreen::setUpFb() {
-  struct fb_var_screeninfo vinfo;
+static cairo_format_t format_for(const struct fb_var_screeninfo& v) {
+  if (v.bits_per_pixel == 16 &&
+      v.red.offset == 11 && v.red.length == 5 &&
+      v.green.offset == 5 && v.green.length == 6 &&
+      v.blue.offset == 0 && v.blue.length == 5) {
+    return CAIRO_FORMAT_RGB16_565;
+  }
+  if (v.bits_per_pixel == 32 &&
+      v.red.offset == 16 && v.red.length == 8 &&
+      v.green.offset == 8 && v.green.length == 8 &&
+      v.blue.offset == 0 && v.blue.length == 8) {
+    return CAIRO_FORMAT_ARGB32;
+  }
+  return CAIRO_FORMAT_INVALID;
+}
+
+void FramebufferScreen::setUpDevice() {
   struct fb_fix_screeninfo finfo;
 
-  // Open the file for reading and writing
-  fbfd_ = open("/dev/fb0", O_RDWR);
-  if (fbfd_ == -1) {
-    perror("Error: cannot open framebuffer device");
-    exit(1);
+  // Get variable screen information
+  if (ioctl(fbfd_, FBIOGET_VSCREENINFO, &vinfo_) == -1) {
+    perror("Error reading variable information");
+    exit(3);
+  }
+
+  format_ = format_for(vinfo_);
+  if (format_ == CAIRO_FORMAT_INVALID) {
+    // Ask for a format we can draw natively, keeping the depth if we can.
+    struct fb_var_screeninfo v = vinfo_;
+    v.bits_per_pixel = vinfo_.bits_per_pixel == 16 ? 16 : 32;
+    if (v.bits_per_pixel == 16) {
+      v.red = {11, 5, 0};
+      v.green = {5, 6, 0};
+      v.blue = {0, 5, 0};
+      v.transp = {0, 0, 0};
+    } else {
+      v.red = {16, 8, 0};
+      v.green = {8, 8, 0};
+      v.blue = {0, 8, 0};
+      v.transp = {24, 8, 0};
+    }
+    if (ioctl(fbfd_, FBIOPUT_VSCREENINFO, &v) == -1 ||
+        ioctl(fbfd_, FBIOGET_VSCREENINFO, &vinfo_) == -1 ||
+        (format_ = format_for(vinfo_)) == CAIRO_FORMAT_INVALID) {
+      std::cerr << "Error: unsupported framebuffer format, "
+                << vinfo_.bits_per_pixel << " bits per pixel" << std::endl;
+      exit(3);
+    }
+  }
+
+  // Ask for room for a second page below the visible one, to pan to.
+  if (vinfo_.yres_virtual < 2 * vinfo_.yres) {
+    struct fb_var_screeninfo v = vinfo_;
+    v.yres_virtual = 2 * vinfo_.yres;
+    v.yoffset = 0;
+    if (ioctl(fbfd_, FBIOPUT_VSCREENINFO, &v) != -1) {
+      ioctl(fbfd_, FBIOGET_VSCREENINFO, &vinfo_);
+    }
   }
 
-  // Get fixed screen information
+  // Get fixed screen information, which depends on the variable information
   if (ioctl(fbfd_, FBIOGET_FSCREENINFO, &finfo) == -1) {
     perror("Error reading fixed information");
     exit(2);
   }
 
-  // Get variable screen information
-  if (ioctl(fbfd_, FBIOGET_VSCREENINFO, &vinfo) == -1) {
-    perror("Error reading variable information");
-    exit(3);
+  xres_ = vinfo_.xres;
+  yres_ = vinfo_.yres;
+  line_length_ = finfo.line_length;
+  num_pages_ = vinfo_.yres_virtual >= 2 * vinfo_.yres ? 2 : 1;
+  screensize_ = (size_t) line_length_ * yres_ * num_pages_;
+  if (screensize_ > finfo.smem_len) {
+    num_pages_ = 1;
+    screensize_ = (size_t) line_length_ * yres_;
   }
 
-  screensize_ = vinfo.xres * vinfo.yres * vinfo.bits_per_pixel / 8;
-
   // Map the device to memory
   fbp_ = (unsigned char *) mmap(0, screensize_, PROT_READ | PROT_WRITE,
                                 MAP_SHARED, fbfd_, 0);
-  if ((size_t) fbp_ == -1) {
+  if (fbp_ == MAP_FAILED) {
     perror("Error: failed to map framebuffer device to memory");
     exit(4);
   }
-  xres_ = vinfo.xres;
-  yres_ = vinfo.yres;
 
   // Set to graphics mode
   ioctl(STDOUT_FILENO, KDSETMODE, KD_GRAPHICS);
   ioctl(STDERR_FILENO, KDSETMODE, KD_GRAPHICS);
 }
 
+void FramebufferScreen::setUpFile(int width, int height, int bits_per_pixel) {
+  if (bits_per_pixel != 16 && bits_per_pixel != 32) {
+    std::cerr << "Error: unsupported framebuffer file depth "
+              << bits_per_pixel << std::endl;
+    exit(3);
+  }
+  format_ = bits_per_pixel == 16 ? CAIRO_FORMAT_RGB16_565 : CAIRO_FORMAT_ARGB32;
+  xres_ = width;
+  yres_ = height;
+  line_length_ = cairo_format_stride_for_width(format_, width);
+  num_pages_ = 1;
+  screensize_ = (size_t) line_length_ * yres_;
+  if (ftruncate(fbfd_, (off_t) screensize_) == -1) {
+    perror("Error: cannot size framebuffer file");
+    exit(4);
+  }
+  fbp_ = (unsigned char *) mmap(0, screensize_, PROT_READ | PROT_WRITE,
+                                MAP_SHARED, fbfd_, 0);
+  if (fbp_ == MAP_FAILED) {
+    perror("Error: failed to map framebuffer file to memory");
+    exit(4);
+  }
+}
+
+void FramebufferScreen::setUpSurfaces() {
+  // Cairo needs rows to be aligned as it would lay them out itself.
+  const int stride = cairo_format_stride_for_width(format_, xres_);
+  const bool drawable = line_length_ % 4 == 0 && line_length_ >= stride;
+  if (!drawable) {
+    num_pages_ = 1;
+  }
+  if (num_pages_ == 2) {
+    for (int i = 0; i < 2; i++) {
+      page_cs_[i] = cairo_image_surface_create_for_data(
+          fbp_ + (size_t) i * yres_ * line_length_,
+          format_, xres_, yres_, line_length_);
+      page_cr_[i] = cairo_create(page_cs_[i]);
+    }
+  } else {
+    back_buffer_ = (unsigned char *) calloc(stride, yres_);
+    page_cs_[0] = cairo_image_surface_create_for_data(
+        back_buffer_, format_, xres_, yres_, stride);
+    page_cr_[0] = cairo_create(page_cs_[0]);
+  }
+}
+
+void FramebufferScreen::select(int page) {
+  drawing_ = page;
+  set_cs(page_cs_[page]);
+  set_cr(page_cr_[page]);
+}
+
+void FramebufferScreen::flush() {
+  cairo_surface_flush(cs());
+  if (num_pages_ == 2) {
+    vinfo_.yoffset = drawing_ * yres_;
+    if (ioctl(fbfd_, FBIOPAN_DISPLAY, &vinfo_) == -1) {
+      perror("Error panning framebuffer");
+    }
+  } else {
+    const int stride = cairo_image_surface_get_stride(cs());
+    const int row_bytes = std::min(stride, line_length_);
+    for (int y = 0; y < yres_; y++) {
+      memcpy(fbp_ + (size_t) y * line_length_, back_buffer_ + (size_t) y * stride, row_bytes);
+    }
+  }
+  if (is_device_ && wait_for_vsync_) {
+    // Not all drivers support this, in which case frames are not paced.
+    uint32_t crtc = 0;
+    ioctl(fbfd_, FBIO_WAITFORVSYNC, &crtc);
+  }
+  if (num_pages_ == 2) {
+    select(1 - drawing_);
+  }
+}
+
 void FramebufferScreen::tearDownFb() {
+  if (is_device_) {
+    ioctl(STDOUT_FILENO, KDSETMODE, KD_TEXT);
+    ioctl(STDERR_FILENO, KDSETMODE, KD_TEXT);
+  }
   munmap(fbp_, screensize_);
   close(fbfd_);
 }
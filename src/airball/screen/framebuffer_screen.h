@@ -1,31 +1,83 @@
 #ifndef AIRBALL_SCREEN_FRAMEBUFFER_SCREEN_H
 #define AIRBALL_SCREEN_FRAMEBUFFER_SCREEN_H
 
+#include <linux/fb.h>
+#include <string>
+
 #include "AbstractScreen.h"
 
 namespace airball {
 
+/**
+ * Encapsulates a Screen which paints to a Linux framebuffer device.
+ *
+ * Frames are drawn natively in the pixel format of the device, which may be
+ * 16 bits per pixel (RGB565) or 32 (XRGB8888). If the device allows a
+ * virtual resolution twice the height of the visible one, frames are drawn
+ * into the half that is not being shown and flush() pans the display to it,
+ * so a frame is never shown half drawn. Otherwise frames are drawn into
+ * memory and copied to the device by flush().
+ *
+ * The path may also be a plain file, which is treated as a framebuffer with
+ * the given size and depth, for measuring throughput without a display.
+ */
 class FramebufferScreen : public AbstractScreen {
 public:
-  FramebufferScreen();
+  /**
+   * Creates a new FramebufferScreen.
+   *
+   * @param path the framebuffer device, such as /dev/fb0, or a plain file.
+   * @param wait_for_vsync whether flush() waits for the vertical blank after
+   *     showing a frame, if the device supports it.
+   * @param file_width the width, if the path is a plain file.
+   * @param file_height the height, if the path is a plain file.
+   * @param file_bits_per_pixel the depth, 16 or 32, if the path is a plain
+   *     file.
+   */
+  FramebufferScreen(
+      const std::string& path,
+      bool wait_for_vsync,
+      int file_width,
+      int file_height,
+      int file_bits_per_pixel);
 
   ~FramebufferScreen() override;
 
-  virtual void flush() override {}
+  void flush() override;
+
+  void setBrightness(double value) override {}
 
 private:
-  void setUpFb();
+  void setUpDevice();
+  void setUpFile(int width, int height, int bits_per_pixel);
+  void setUpSurfaces();
   void tearDownFb();
 
+  // Point cr() and cs() at the given page.
+  void select(int page);
+
+  const std::string path_;
+  const bool wait_for_vsync_;
+  bool is_device_;
+
   int fbfd_;
   unsigned char *fbp_;
+  size_t screensize_;
+  struct fb_var_screeninfo vinfo_;
   int xres_;
   int yres_;
-  long int screensize_;
-  cairo_surface_t *cs_;
-  cairo_t *cr_;
+  int line_length_;
+  cairo_format_t format_;
+
+  // The pages that can be drawn into: two halves of the mapping when
+  // panning, or one buffer in memory that is copied to the mapping.
+  int num_pages_;
+  int drawing_;
+  unsigned char* back_buffer_;
+  cairo_surface_t *page_cs_[2];
+  cairo_t *page_cr_[2];
 };
 
 }  // namespace airball
 
-#endif // AIRBALL_SCREEN_FRAMEBUFFER_SCREEN_H
\ No newline at end of file
+#endif // AIRBALL_SCREEN_FRAMEBUFFER_SCREEN_H
@@ -1,28 +1,141 @@
 #include "image_screen.h"
 
-#include <csignal>
+#include <cstring>
+#include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 namespace airball {
 
-ImageScreen::ImageScreen(int w, int h)
-    : image_index_(0) {
+ImageScreen::ImageScreen(
+    int w,
+    int h,
+    Mode mode,
+    const std::string& path,
+    int num_workers)
+    : mode_(mode),
+      path_(path),
+      width_(w),
+      height_(h),
+      stride_(cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, w)),
+      frame_bytes_((size_t) stride_ * h),
+      image_index_(0),
+      raw_fd_(-1),
+      raw_map_(nullptr),
+      raw_map_bytes_(0),
+      raw_map_offset_(0),
+      raw_first_frame_(0) {
   set_cs(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h));
   set_cr(cairo_create(cs()));
+  if (mode_ == Mode::PNG) {
+    for (int i = 0; i < kNumBuffers; i++) {
+      buffers_.push_back(std::make_unique<unsigned char[]>(frame_bytes_));
+      free_.push_back(i);
+    }
+    workers_ = std::make_unique<ThreadPool>(num_workers);
+  } else {
+    const std::string file_name = path_ + ".raw";
+    raw_fd_ = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (raw_fd_ == -1) {
+      perror("Error: cannot open raw image file");
+      exit(1);
+    }
+  }
 }
 
-void write_to_png(cairo_surface_t* cs, std::string file_name) {
-  cairo_surface_write_to_png(cs, file_name.c_str());
-  cairo_surface_flush(cs);
+ImageScreen::~ImageScreen() {
+  if (mode_ == Mode::PNG) {
+    workers_.reset();
+  } else {
+    unmapRaw();
+    // Trim the space reserved for frames that were never captured.
+    if (ftruncate(raw_fd_, (off_t) (frame_bytes_ * image_index_)) == -1) {
+      perror("Error: cannot truncate raw image file");
+    }
+    close(raw_fd_);
+  }
+  cairo_destroy(cr());
+  cairo_surface_destroy(cs());
 }
 
 void ImageScreen::flush() {
-  char buf[128];
-  snprintf(buf, sizeof(buf), "image%08ld.png", image_index_);
-  write_to_png(cs(), buf);
-  sync();
+  cairo_surface_flush(cs());
+  if (mode_ == Mode::PNG) {
+    flushPng();
+  } else {
+    flushRaw();
+  }
   image_index_++;
 }
 
+void ImageScreen::flushPng() {
+  int index;
+  {
+    std::unique_lock<std::mutex> lock(free_mu_);
+    free_cv_.wait(lock, [this]() { return !free_.empty(); });
+    index = free_.back();
+    free_.pop_back();
+  }
+  memcpy(buffers_[index].get(), cairo_image_surface_get_data(cs()), frame_bytes_);
+
+  const unsigned long image_index = image_index_;
+  workers_->submit([this, index, image_index]() {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s%08ld.png", path_.c_str(), image_index);
+    cairo_surface_t* cs = cairo_image_surface_create_for_data(
+        buffers_[index].get(), CAIRO_FORMAT_ARGB32, width_, height_, stride_);
+    cairo_surface_write_to_png(cs, buf);
+    cairo_surface_destroy(cs);
+    {
+      std::lock_guard<std::mutex> lock(free_mu_);
+      free_.push_back(index);
+    }
+    free_cv_.notify_one();
+  });
+}
+
+void ImageScreen::flushRaw() {
+  if (raw_map_ == nullptr ||
+      image_index_ >= raw_first_frame_ + kRawFramesPerMapping) {
+    unmapRaw();
+    mapRaw();
+  }
+  memcpy(
+      raw_map_ + raw_map_offset_ + (image_index_ - raw_first_frame_) * frame_bytes_,
+      cairo_image_surface_get_data(cs()),
+      frame_bytes_);
+}
+
+void ImageScreen::mapRaw() {
+  // Mappings must start at a page boundary, which may be within the last
+  // frame of the previous mapping.
+  const size_t start = frame_bytes_ * image_index_;
+  const size_t page_start = start - start % sysconf(_SC_PAGESIZE);
+  const size_t end = start + frame_bytes_ * kRawFramesPerMapping;
+  if (ftruncate(raw_fd_, (off_t) end) == -1) {
+    perror("Error: cannot extend raw image file");
+    exit(1);
+  }
+  raw_map_bytes_ = end - page_start;
+  raw_map_ = (unsigned char*) mmap(
+      nullptr, raw_map_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED,
+      raw_fd_, (off_t) page_start);
+  if (raw_map_ == MAP_FAILED) {
+    perror("Error: cannot map raw image file");
+    exit(1);
+  }
+  raw_map_offset_ = start - page_start;
+  raw_first_frame_ = image_index_;
+}
+
+void ImageScreen::unmapRaw() {
+  if (raw_map_ == nullptr) {
+    return;
+  }
+  munmap(raw_map_, raw_map_bytes_);
+  raw_map_ = nullptr;
+}
+
 }  // namespace airball
@@ -1,31 +1,87 @@
 #ifndef AIRBALL_SCREEN_IMAGE_SCREEN_H
 #define AIRBALL_SCREEN_IMAGE_SCREEN_H
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include "AbstractScreen.h"
+#include "../util/thread_pool.h"
 
 namespace airball {
 
 /**
- * Encapsulates a Screen which paints to an in-memory buffered image.
+ * Encapsulates a Screen which paints to an in-memory buffered image, and
+ * captures every frame to files.
+ *
+ * Capturing a frame copies it, and any encoding and writing is done away
+ * from the thread that calls flush().
  */
 class ImageScreen : public AbstractScreen {
 public:
+  enum class Mode {
+    // Each frame is written to its own PNG file, named by appending the
+    // frame number to the path.
+    PNG,
+    // Frames are appended, uncompressed, to one file named by appending
+    // ".raw" to the path. Each frame is the ARGB32 image data, of
+    // cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, w) * h bytes.
+    RAW,
+  };
 
   /**
    * Creates a new ImageScreen.
    *
    * @param w the width of the Screen.
    * @param h the height of the Screen.
+   * @param mode how frames are captured.
+   * @param path the prefix of the names of the files captured to.
+   * @param num_workers the number of threads encoding PNG files.
    */
-  ImageScreen(int w, int h);
+  ImageScreen(int w, int h, Mode mode, const std::string& path, int num_workers);
+
+  ~ImageScreen() override;
 
   void flush() override;
 
   void setBrightness(double value) override {}
 
 private:
+  // The number of frames that may be waiting to be encoded before flush()
+  // waits for one to finish.
+  static constexpr int kNumBuffers = 8;
+  // The number of frames by which the raw file is extended at a time.
+  static constexpr int kRawFramesPerMapping = 64;
+
+  void flushPng();
+  void flushRaw();
+  void mapRaw();
+  void unmapRaw();
+
+  const Mode mode_;
+  const std::string path_;
+  const int width_;
+  const int height_;
+  const int stride_;
+  const size_t frame_bytes_;
   unsigned long image_index_;
+
+  // Buffers of frames waiting to be encoded, and the indices of those that
+  // are free.
+  std::vector<std::unique_ptr<unsigned char[]>> buffers_;
+  std::mutex free_mu_;
+  std::condition_variable free_cv_;
+  std::vector<int> free_;
+  std::unique_ptr<ThreadPool> workers_;
+
+  // The raw file, and the part of it currently mapped into memory, which
+  // holds the frames from raw_first_frame_ onwards.
+  int raw_fd_;
+  unsigned char* raw_map_;
+  size_t raw_map_bytes_;
+  size_t raw_map_offset_;
+  unsigned long raw_first_frame_;
 };
 
 }  // namespace airball
@@ -0,0 +1,21 @@
+#include "memory_screen.h"
+
+namespace airball {
+
+MemoryScreen::MemoryScreen(cairo_format_t format, int w, int h)
+    : frames_(0) {
+  set_cs(cairo_image_surface_create(format, w, h));
+  set_cr(cairo_create(cs()));
+}
+
+MemoryScreen::~MemoryScreen() {
+  cairo_destroy(cr());
+  cairo_surface_destroy(cs());
+}
+
+void MemoryScreen::flush() {
+  cairo_surface_flush(cs());
+  frames_++;
+}
+
+}  // namespace airball
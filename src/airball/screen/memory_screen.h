@@ -0,0 +1,41 @@
+#ifndef AIRBALL_SCREEN_MEMORY_SCREEN_H
+#define AIRBALL_SCREEN_MEMORY_SCREEN_H
+
+#include "AbstractScreen.h"
+
+namespace airball {
+
+/**
+ * Encapsulates a Screen which paints to an in-memory image and does nothing
+ * with it, for measuring and testing drawing without a display.
+ */
+class MemoryScreen : public AbstractScreen {
+public:
+
+  /**
+   * Creates a new MemoryScreen.
+   *
+   * @param format the pixel format of the image.
+   * @param w the width of the Screen.
+   * @param h the height of the Screen.
+   */
+  MemoryScreen(cairo_format_t format, int w, int h);
+
+  ~MemoryScreen() override;
+
+  void flush() override;
+
+  void setBrightness(double value) override {}
+
+  /**
+   * @return the number of times flush() has been called.
+   */
+  unsigned long frames() const { return frames_; }
+
+private:
+  unsigned long frames_;
+};
+
+}  // namespace airball
+
+#endif // AIRBALL_SCREEN_MEMORY_SCREEN_H
@@ -0,0 +1,93 @@
+#include "pipelined_screen.h"
+
+#include <stdlib.h>
+
+#include "../../framework/StageTimers.h"
+
+namespace airball {
+
+PipelinedScreen::PipelinedScreen(
+    cairo_format_t format,
+    int width,
+    int height,
+    int num_buffers)
+    : stride_(cairo_format_stride_for_width(format, width)),
+      drawing_(0),
+      stopping_(false) {
+  for (int i = 0; i < num_buffers; i++) {
+    Buffer b;
+    b.data = (unsigned char *) calloc(stride_, height);
+    b.cs = cairo_image_surface_create_for_data(b.data, format, width, height, stride_);
+    b.cr = cairo_create(b.cs);
+    buffers_.push_back(b);
+  }
+  select(0);
+}
+
+PipelinedScreen::~PipelinedScreen() {
+  stop();
+  for (auto& b : buffers_) {
+    cairo_destroy(b.cr);
+    cairo_surface_destroy(b.cs);
+    free(b.data);
+  }
+}
+
+void PipelinedScreen::select(int index) {
+  drawing_ = index;
+  set_cs(buffers_[index].cs);
+  set_cr(buffers_[index].cr);
+}
+
+void PipelinedScreen::start() {
+  thread_ = std::thread([this]() { run(); });
+}
+
+void PipelinedScreen::stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void PipelinedScreen::flush() {
+  cairo_surface_flush(cs());
+  std::unique_lock<std::mutex> lock(mu_);
+  queued_.push_back(drawing_);
+  cv_.notify_all();
+  // Buffers are used in rotation and presented in order, so the next buffer
+  // is free once no more than the others are queued.
+  cv_.wait(lock, [this]() {
+    return queued_.size() < buffers_.size();
+  });
+  select((drawing_ + 1) % buffers_.size());
+}
+
+void PipelinedScreen::run() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    cv_.wait(lock, [this]() {
+      return stopping_ || !queued_.empty();
+    });
+    if (queued_.empty()) {
+      // Stopping, with everything flushed already presented.
+      return;
+    }
+    const Buffer& b = buffers_[queued_.front()];
+    lock.unlock();
+    {
+      AIRBALL_TIME_STAGE("present");
+      present(b.data, stride_);
+    }
+    lock.lock();
+    queued_.pop_front();
+    cv_.notify_all();
+  }
+}
+
+}  // namespace airball
@@ -0,0 +1,74 @@
+#ifndef AIRBALL_SCREEN_PIPELINED_SCREEN_H
+#define AIRBALL_SCREEN_PIPELINED_SCREEN_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AbstractScreen.h"
+
+namespace airball {
+
+/**
+ * A screen that presents frames to its device on a thread of its own.
+ *
+ * The screen has several image buffers. The application draws into one of
+ * them; flush() queues that buffer for presentation and moves the
+ * application on to the next buffer, so that drawing a frame overlaps with
+ * sending the previous one to the device. flush() only blocks if every other
+ * buffer is still waiting to be presented.
+ *
+ * Subclasses implement present(), and must call start() at the end of their
+ * constructor and stop() at the start of their destructor, so that the
+ * present thread never runs against a partly constructed or destroyed object.
+ */
+class PipelinedScreen : public AbstractScreen {
+public:
+  /**
+   * @param format the pixel format of the buffers.
+   * @param width the width of the buffers.
+   * @param height the height of the buffers.
+   * @param num_buffers the number of buffers, at least 2.
+   */
+  PipelinedScreen(cairo_format_t format, int width, int height, int num_buffers);
+
+  ~PipelinedScreen() override;
+
+  void flush() override;
+
+protected:
+  // Send a buffer to the device. Called on the present thread, one buffer at
+  // a time, in the order the buffers were flushed.
+  virtual void present(const unsigned char* data, int stride) = 0;
+
+  void start();
+  void stop();
+
+private:
+  struct Buffer {
+    unsigned char* data;
+    cairo_surface_t* cs;
+    cairo_t* cr;
+  };
+
+  void select(int index);
+  void run();
+
+  const int stride_;
+  std::vector<Buffer> buffers_;
+  int drawing_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  // Buffers flushed and not yet completely presented, oldest first. The front
+  // entry is the one being presented, if any.
+  std::deque<int> queued_;
+  bool stopping_;
+  std::thread thread_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_SCREEN_PIPELINED_SCREEN_H
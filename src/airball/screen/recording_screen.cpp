@@ -0,0 +1,157 @@
+#include "recording_screen.h"
+
+#include <cstring>
+#include <stdlib.h>
+
+#include "frame_delta_codec.h"
+
+namespace airball {
+
+static FILE* open_or_exit(const std::string& file_name) {
+  FILE* f = fopen(file_name.c_str(), "w");
+  if (f == nullptr) {
+    perror(("Error: cannot open recording file " + file_name).c_str());
+    exit(1);
+  }
+  return f;
+}
+
+RecordingScreen::RecordingScreen(
+    std::unique_ptr<IScreen> screen,
+    const std::string& path,
+    int keyframe_interval)
+    : screen_(std::move(screen)),
+      keyframe_interval_(keyframe_interval),
+      start_(std::chrono::steady_clock::now()),
+      frame_(0),
+      dropped_(0),
+      offset_(0),
+      frames_since_keyframe_(0) {
+  // Screens that do not draw to an image in memory, like X11, can still be
+  // read by mapping them to an image.
+  cairo_surface_t* image = cairo_surface_map_to_image(cs(), nullptr);
+  const cairo_format_t format = cairo_image_surface_get_format(image);
+  const int width = cairo_image_surface_get_width(image);
+  const int height = cairo_image_surface_get_height(image);
+  cairo_surface_unmap_image(cs(), image);
+
+  header_ = {
+      .magic = kMagic,
+      .version = kVersion,
+      .format = format,
+      .width = width,
+      .height = height,
+      .stride = cairo_format_stride_for_width(format, width),
+  };
+  frame_bytes_ = (size_t) header_.stride * height;
+
+  for (int i = 0; i < kNumBuffers; i++) {
+    buffers_.emplace_back(frame_bytes_ / sizeof(uint32_t));
+    free_.push_back(i);
+  }
+
+  file_ = open_or_exit(path + ".abv");
+  index_ = open_or_exit(path + ".abi");
+  fwrite(&header_, sizeof(header_), 1, file_);
+  offset_ = sizeof(header_);
+
+  encoder_ = std::make_unique<ThreadPool>(1);
+}
+
+RecordingScreen::~RecordingScreen() {
+  // Record whatever is still waiting before closing the files.
+  encoder_.reset();
+  fclose(index_);
+  fclose(file_);
+}
+
+unsigned long RecordingScreen::dropped() const {
+  std::lock_guard<std::mutex> lock(free_mu_);
+  return dropped_;
+}
+
+void RecordingScreen::flush() {
+  const uint64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_).count();
+  const unsigned long frame = frame_++;
+
+  int index = -1;
+  {
+    std::lock_guard<std::mutex> lock(free_mu_);
+    if (free_.empty()) {
+      dropped_++;
+    } else {
+      index = free_.back();
+      free_.pop_back();
+    }
+  }
+
+  if (index >= 0) {
+    capture((unsigned char*) buffers_[index].data());
+    encoder_->submit([this, index, frame, time_us]() {
+      record(index, frame, time_us);
+    });
+  }
+
+  screen_->flush();
+}
+
+void RecordingScreen::capture(unsigned char* buffer) {
+  cairo_surface_t* image = cairo_surface_map_to_image(cs(), nullptr);
+  const unsigned char* data = cairo_image_surface_get_data(image);
+  const int stride = cairo_image_surface_get_stride(image);
+  if (stride == header_.stride) {
+    memcpy(buffer, data, frame_bytes_);
+  } else {
+    for (int y = 0; y < header_.height; y++) {
+      memcpy(buffer + y * header_.stride, data + y * stride, header_.stride);
+    }
+  }
+  cairo_surface_unmap_image(cs(), image);
+}
+
+void RecordingScreen::record(int index, unsigned long frame, uint64_t time_us) {
+  const std::vector<uint32_t>& buffer = buffers_[index];
+  const bool keyframe =
+      previous_.empty() || frames_since_keyframe_ >= (unsigned long) keyframe_interval_;
+
+  encoded_.clear();
+  frame_delta_codec::encode(
+      buffer.data(),
+      keyframe ? nullptr : previous_.data(),
+      buffer.size(),
+      encoded_);
+  previous_ = buffer;
+  frames_since_keyframe_ = keyframe ? 1 : frames_since_keyframe_ + 1;
+
+  {
+    std::lock_guard<std::mutex> lock(free_mu_);
+    free_.push_back(index);
+  }
+
+  const FrameHeader h = {
+      .size = (uint32_t) encoded_.size(),
+      .keyframe = keyframe ? 1u : 0u,
+      .frame = frame,
+      .time_us = time_us,
+  };
+  if (keyframe) {
+    const IndexEntry e = {
+        .frame = frame,
+        .offset = offset_,
+        .time_us = time_us,
+    };
+    fwrite(&e, sizeof(e), 1, index_);
+  }
+  fwrite(&h, sizeof(h), 1, file_);
+  fwrite(encoded_.data(), 1, encoded_.size(), file_);
+  offset_ += sizeof(h) + encoded_.size();
+  if (keyframe) {
+    // Push everything up to each keyframe out to the files, so that little
+    // is lost if the program stops.
+    fflush(file_);
+    fflush(index_);
+  }
+}
+
+}  // namespace airball
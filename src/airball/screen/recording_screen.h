@@ -0,0 +1,130 @@
+#ifndef AIRBALL_SCREEN_RECORDING_SCREEN_H
+#define AIRBALL_SCREEN_RECORDING_SCREEN_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "../../framework/IScreen.h"
+#include "../util/thread_pool.h"
+
+namespace airball {
+
+/**
+ * A Screen that passes everything through to another Screen, and also
+ * records every frame flushed to it to a file.
+ *
+ * Frames are encoded with frame_delta_codec, as a delta from the frame
+ * before, with a keyframe at regular intervals so that playback can start
+ * part way through. Copying a frame is the only work done on the thread
+ * that calls flush(); encoding and writing are done on a thread of their
+ * own. If that thread falls behind, frames are dropped rather than holding
+ * up the display.
+ *
+ * The recording is written to <path>.abv, which starts with a FileHeader
+ * and continues with a FrameHeader followed by the encoded frame, for each
+ * frame. An index of the keyframes is written to <path>.abi, as an
+ * IndexEntry for each keyframe. All values are little endian.
+ */
+class RecordingScreen : public IScreen {
+public:
+  static constexpr uint32_t kMagic = 0x52564241;  // "ABVR"
+  static constexpr uint32_t kVersion = 1;
+
+  struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    // The cairo_format_t of the frames.
+    int32_t format;
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+  };
+
+  struct FrameHeader {
+    // The number of bytes of the encoded frame that follow.
+    uint32_t size;
+    // 1 if the frame is a keyframe, otherwise 0.
+    uint32_t keyframe;
+    // The number of the frame, counting any dropped.
+    uint64_t frame;
+    // When the frame was flushed, in microseconds since the recording began.
+    uint64_t time_us;
+  };
+
+  struct IndexEntry {
+    uint64_t frame;
+    // The offset in the recording of the frame's FrameHeader.
+    uint64_t offset;
+    uint64_t time_us;
+  };
+
+  /**
+   * Creates a new RecordingScreen.
+   *
+   * @param screen the Screen to pass through to.
+   * @param path the prefix of the names of the files to record to.
+   * @param keyframe_interval the number of frames from one keyframe to the
+   *     next.
+   */
+  RecordingScreen(
+      std::unique_ptr<IScreen> screen,
+      const std::string& path,
+      int keyframe_interval);
+
+  ~RecordingScreen() override;
+
+  cairo_t *cr() const override { return screen_->cr(); }
+  cairo_surface_t *cs() const override { return screen_->cs(); }
+
+  void flush() override;
+
+  void setBrightness(double value) override { screen_->setBrightness(value); }
+
+  uint64_t bytes_transferred() const override { return screen_->bytes_transferred(); }
+
+  /**
+   * @return the number of frames not recorded because the encoder was busy.
+   */
+  unsigned long dropped() const;
+
+private:
+  // The number of frames that may be waiting to be encoded.
+  static constexpr int kNumBuffers = 4;
+
+  void capture(unsigned char* buffer);
+  void record(int index, unsigned long frame, uint64_t time_us);
+
+  std::unique_ptr<IScreen> screen_;
+  const int keyframe_interval_;
+  const std::chrono::steady_clock::time_point start_;
+
+  FileHeader header_;
+  size_t frame_bytes_;
+  unsigned long frame_;
+
+  // Buffers of frames waiting to be encoded, and the indices of those that
+  // are free.
+  std::vector<std::vector<uint32_t>> buffers_;
+  mutable std::mutex free_mu_;
+  std::vector<int> free_;
+  unsigned long dropped_;
+
+  // Used only on the encoder thread.
+  FILE* file_;
+  FILE* index_;
+  uint64_t offset_;
+  std::vector<uint32_t> previous_;
+  unsigned long frames_since_keyframe_;
+  std::vector<uint8_t> encoded_;
+
+  std::unique_ptr<ThreadPool> encoder_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_SCREEN_RECORDING_SCREEN_H
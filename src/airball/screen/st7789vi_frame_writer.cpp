@@ -81,16 +81,8 @@ void st7789vi_frame_writer::initialize() {
   data_out(0x1c, 0x18);
   data_out(0x16, 0x19);
 
-  /*
-  command_out(0x2a);  //x address set
-  data_out(0x00, 0x00);
-  data_out(0x00, 0xef);
-
-  command_out(0x2b);  //y address set
-  data_out(0x00, 0x00);
-  data_out(0x01, 0x3f);
+  set_window(0, 0, kPanelWidth - 1, kPanelHeight - 1);
   delay(10);
-  */
 
   command_out(0x29);  //display on
   delay(100);
@@ -140,10 +132,32 @@ void st7789vi_frame_writer::fail(const char *msg) {
   exit(1);
 }
 
+void st7789vi_frame_writer::set_window(int x0, int y0, int x1, int y1) {
+  command_out(0x2a);  //x address set
+  data_out((uint8_t) (x0 >> 8), (uint8_t) (x0 & 0xff));
+  data_out((uint8_t) (x1 >> 8), (uint8_t) (x1 & 0xff));
+
+  command_out(0x2b);  //y address set
+  data_out((uint8_t) (y0 >> 8), (uint8_t) (y0 & 0xff));
+  data_out((uint8_t) (y1 >> 8), (uint8_t) (y1 & 0xff));
+}
+
 void st7789vi_frame_writer::write_frame(uint16_t *frame, int len) {
-  command_out(0x2c);
+  // A previous partial update may have left a smaller window in place.
+  set_window(0, 0, kPanelWidth - 1, kPanelHeight - 1);
+  memory_write(frame, len);
+}
+
+void st7789vi_frame_writer::write_window(
+    uint16_t *data, int x0, int y0, int x1, int y1) {
+  set_window(x0, y0, x1, y1);
+  memory_write(data, (x1 - x0 + 1) * (y1 - y0 + 1));
+}
+
+void st7789vi_frame_writer::memory_write(uint16_t *data, int len) {
+  command_out(0x2c);  //ramwr: memory write
   write_single_gpio(kPinDataCommand, kPinStateHigh);
-  write_data(frame, len);
+  write_data(data, len);
 }
 
 void st7789vi_frame_writer::set_brightness(uint8_t brightness) {
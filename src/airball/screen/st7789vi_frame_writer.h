@@ -11,10 +11,20 @@ class st7789vi_frame_writer {
   st7789vi_frame_writer() = default;
   virtual ~st7789vi_frame_writer() = default;
 
+  // The size of the panel, in pixels, in its native orientation.
+  constexpr static int kPanelWidth  = 240;
+  constexpr static int kPanelHeight = 320;
+
   virtual void initialize();
 
+  // Write a full frame of kPanelWidth * kPanelHeight pixels.
   void write_frame(uint16_t* frame, int len);
 
+  // Write the pixels of a window spanning columns x0 through x1 and rows y0
+  // through y1, inclusive. The data holds (x1 - x0 + 1) * (y1 - y0 + 1)
+  // pixels in row-major order.
+  void write_window(uint16_t* data, int x0, int y0, int x1, int y1);
+
   void set_brightness(uint8_t brightness);
 
 protected:
@@ -27,6 +37,8 @@ protected:
   virtual void write_data(uint16_t* buf, int len) = 0;
 
 private:
+  void set_window(int x0, int y0, int x1, int y1);
+  void memory_write(uint16_t* data, int len);
   void command_out(uint8_t c);
   void delay(uint16_t ms);
   void write_word(uint16_t b);
@@ -2,28 +2,31 @@
 
 #include <iostream>
 #include <stdint.h>
+#include <string.h>
 
 namespace airball {
 
 constexpr uint32_t kWidth = 240;
 constexpr uint32_t kHeight = 320;
-  
-ST7789VIScreen::ST7789VIScreen() {
+
+// The size of the square tiles compared to find changed parts of the frame.
+constexpr int kTileSize = 16;
+
+// One buffer is drawn while the other is sent to the panel.
+constexpr int kNumBuffers = 2;
+
+ST7789VIScreen::ST7789VIScreen()
+    : PipelinedScreen(CAIRO_FORMAT_RGB16_565, kWidth, kHeight, kNumBuffers),
+      damage_(kWidth, kHeight, sizeof(uint16_t), kTileSize),
+      window_(kWidth * kHeight),
+      bytes_last_frame_(0),
+      bytes_total_(0) {
   w_.initialize();
-  data_ = (unsigned char *) malloc(sizeof(uint16_t) * kWidth * kHeight);
-  set_cs(cairo_image_surface_create_for_data(
-      data_,
-      CAIRO_FORMAT_RGB16_565,
-      kWidth,
-      kHeight,
-      cairo_format_stride_for_width(CAIRO_FORMAT_RGB16_565, kWidth)));
-  set_cr(cairo_create(cs()));
+  start();
 }
 
 ST7789VIScreen::~ST7789VIScreen() {
-  cairo_destroy(cr());
-  cairo_surface_destroy(cs());
-  free(data_);
+  stop();
 }
 
 void ST7789VIScreen::setBrightness(double value) {
@@ -32,8 +35,27 @@ void ST7789VIScreen::setBrightness(double value) {
   w_.set_brightness(value * 255);
 }
 
-void ST7789VIScreen::flush() {
-  w_.write_frame((uint16_t *) data_, kWidth * kHeight);
+void ST7789VIScreen::present(const unsigned char* data, int stride) {
+  size_t bytes = 0;
+  for (const auto& r : damage_.update(data, stride)) {
+    uint16_t* pixels;
+    if (r.w == kWidth) {
+      // Full width rows are already contiguous.
+      pixels = (uint16_t *) (data + r.y * stride);
+    } else {
+      for (int y = 0; y < r.h; y++) {
+        memcpy(
+            window_.data() + y * r.w,
+            data + (r.y + y) * stride + r.x * sizeof(uint16_t),
+            r.w * sizeof(uint16_t));
+      }
+      pixels = window_.data();
+    }
+    w_.write_window(pixels, r.x, r.y, r.x + r.w - 1, r.y + r.h - 1);
+    bytes += r.w * r.h * sizeof(uint16_t);
+  }
+  bytes_last_frame_ = bytes;
+  bytes_total_ += bytes;
 }
   
 }  // namespace airball
@@ -1,29 +1,43 @@
 #ifndef AIRBALL_SCREEN_ST7789VI_SCREEN_H
 #define AIRBALL_SCREEN_ST7789VI_SCREEN_H
 
-#include <condition_variable>
-#include <mutex>
-#include <thread>
+#include <atomic>
+#include <vector>
 
-#include "AbstractScreen.h"
+#include "pipelined_screen.h"
 
 #include "st7789vi_frame_writer_smi.h"
+#include "tile_damage_tracker.h"
 
 namespace airball {
 
-class ST7789VIScreen : public AbstractScreen {
+class ST7789VIScreen : public PipelinedScreen {
 public:
   ST7789VIScreen();
 
   ~ST7789VIScreen() override;
 
-  virtual void flush() override;
-
   void setBrightness(double value) override;
 
+  uint64_t bytes_transferred() const override { return bytes_transferred_total(); }
+
+  // The number of pixel data bytes sent to the panel for the last frame.
+  size_t bytes_transferred_last_frame() const { return bytes_last_frame_; }
+
+  // The number of pixel data bytes sent to the panel since startup.
+  uint64_t bytes_transferred_total() const { return bytes_total_; }
+
+protected:
+  void present(const unsigned char* data, int stride) override;
+
 private:
   st7789vi_frame_writer_smi w_;
-  unsigned char *data_;
+  TileDamageTracker damage_;
+  // Staging area for windows narrower than the frame, whose rows are not
+  // contiguous in the frame buffer.
+  std::vector<uint16_t> window_;
+  std::atomic<size_t> bytes_last_frame_;
+  std::atomic<uint64_t> bytes_total_;
 };
 
 }  // namespace airball
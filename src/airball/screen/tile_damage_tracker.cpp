@@ -0,0 +1,140 @@
+#include "tile_damage_tracker.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace airball {
+
+// Changed runs of tiles in a row that are separated by no more than this many
+// unchanged tiles are sent as one window. Each window costs a handful of
+// command and parameter writes, which is about the price of a small tile.
+constexpr int kMaxGapTiles = 1;
+
+// When more than this fraction of the frame has changed, it is cheaper to
+// send the whole frame than to send many separate windows.
+constexpr double kFullFrameFraction = 0.75;
+
+TileDamageTracker::TileDamageTracker(
+    int width,
+    int height,
+    int bytes_per_pixel,
+    int tile_size)
+    : width_(width),
+      height_(height),
+      bytes_per_pixel_(bytes_per_pixel),
+      tile_size_(tile_size),
+      tiles_x_((width + tile_size - 1) / tile_size),
+      tiles_y_((height + tile_size - 1) / tile_size),
+      have_previous_(false),
+      hashes_(tiles_x_ * tiles_y_, 0),
+      dirty_(tiles_x_ * tiles_y_, false) {}
+
+void TileDamageTracker::reset() {
+  have_previous_ = false;
+}
+
+uint64_t TileDamageTracker::hash_tile(
+    const unsigned char* data,
+    int stride,
+    int tx,
+    int ty) const {
+  // FNV-1a, consuming 8 bytes at a time where possible. This is not meant to
+  // resist collisions by an adversary, only to notice that pixels changed.
+  constexpr uint64_t kPrime = 0x100000001b3ULL;
+  uint64_t h = 0xcbf29ce484222325ULL;
+  const int x0 = tx * tile_size_;
+  const int y0 = ty * tile_size_;
+  const int x1 = std::min(x0 + tile_size_, width_);
+  const int y1 = std::min(y0 + tile_size_, height_);
+  const size_t row_bytes = (size_t) (x1 - x0) * bytes_per_pixel_;
+  for (int y = y0; y < y1; y++) {
+    const unsigned char* p = data + (size_t) y * stride + (size_t) x0 * bytes_per_pixel_;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= row_bytes; i += sizeof(uint64_t)) {
+      uint64_t w;
+      memcpy(&w, p + i, sizeof(w));
+      h = (h ^ w) * kPrime;
+    }
+    for (; i < row_bytes; i++) {
+      h = (h ^ p[i]) * kPrime;
+    }
+  }
+  return h;
+}
+
+void TileDamageTracker::full_frame() {
+  rects_.clear();
+  rects_.push_back({0, 0, width_, height_});
+}
+
+void TileDamageTracker::add_run(int x0, int x1, int ty) {
+  const int px0 = x0 * tile_size_;
+  const int px1 = std::min((x1 + 1) * tile_size_, width_);
+  const int py0 = ty * tile_size_;
+  const int py1 = std::min(py0 + tile_size_, height_);
+  // Grow a rectangle from the previous tile row if it spans the same columns.
+  for (auto& r : rects_) {
+    if (r.x == px0 && r.w == px1 - px0 && r.y + r.h == py0) {
+      r.h += py1 - py0;
+      return;
+    }
+  }
+  rects_.push_back({px0, py0, px1 - px0, py1 - py0});
+}
+
+const std::vector<TileDamageTracker::Rect>& TileDamageTracker::update(
+    const unsigned char* data,
+    int stride) {
+  int dirty_count = 0;
+  for (int ty = 0; ty < tiles_y_; ty++) {
+    for (int tx = 0; tx < tiles_x_; tx++) {
+      const int i = ty * tiles_x_ + tx;
+      const uint64_t h = hash_tile(data, stride, tx, ty);
+      dirty_[i] = !have_previous_ || h != hashes_[i];
+      hashes_[i] = h;
+      if (dirty_[i]) {
+        dirty_count++;
+      }
+    }
+  }
+
+  if (!have_previous_) {
+    have_previous_ = true;
+    full_frame();
+    return rects_;
+  }
+
+  rects_.clear();
+  if (dirty_count == 0) {
+    return rects_;
+  }
+  if (dirty_count > kFullFrameFraction * tiles_x_ * tiles_y_) {
+    full_frame();
+    return rects_;
+  }
+
+  for (int ty = 0; ty < tiles_y_; ty++) {
+    int run_start = -1;
+    int run_end = -1;
+    for (int tx = 0; tx < tiles_x_; tx++) {
+      if (!dirty_[ty * tiles_x_ + tx]) {
+        continue;
+      }
+      if (run_start >= 0 && tx - run_end - 1 > kMaxGapTiles) {
+        add_run(run_start, run_end, ty);
+        run_start = -1;
+      }
+      if (run_start < 0) {
+        run_start = tx;
+      }
+      run_end = tx;
+    }
+    if (run_start >= 0) {
+      add_run(run_start, run_end, ty);
+    }
+  }
+
+  return rects_;
+}
+
+}  // namespace airball
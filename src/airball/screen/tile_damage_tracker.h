@@ -0,0 +1,70 @@
+#ifndef AIRBALL_SCREEN_TILE_DAMAGE_TRACKER_H
+#define AIRBALL_SCREEN_TILE_DAMAGE_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace airball {
+
+/**
+ * Finds the parts of a frame buffer that changed since the previous frame.
+ *
+ * The frame is divided into tiles, and a hash of each tile is compared with
+ * the hash of the same tile in the previous frame. Changed tiles are then
+ * gathered into a small number of rectangles, suitable for sending to a
+ * display controller as address windows.
+ */
+class TileDamageTracker {
+public:
+  struct Rect {
+    int x;
+    int y;
+    int w;
+    int h;
+  };
+
+  /**
+   * Creates a new TileDamageTracker.
+   *
+   * @param width the width of the frame, in pixels.
+   * @param height the height of the frame, in pixels.
+   * @param bytes_per_pixel the size of each pixel.
+   * @param tile_size the width and height of each tile, in pixels.
+   */
+  TileDamageTracker(int width, int height, int bytes_per_pixel, int tile_size);
+
+  /**
+   * Compare a frame with the previous one given to this tracker.
+   *
+   * @param data the frame.
+   * @param stride the distance, in bytes, between successive rows.
+   * @return the rectangles that changed. The first frame, and the first frame
+   *     after a call to reset(), is reported as entirely changed.
+   */
+  const std::vector<Rect>& update(const unsigned char* data, int stride);
+
+  // Forget the previous frame, so that the next one is reported in full.
+  void reset();
+
+private:
+  uint64_t hash_tile(const unsigned char* data, int stride, int tx, int ty) const;
+  void add_run(int x0, int x1, int ty);
+  void full_frame();
+
+  const int width_;
+  const int height_;
+  const int bytes_per_pixel_;
+  const int tile_size_;
+  const int tiles_x_;
+  const int tiles_y_;
+
+  bool have_previous_;
+  std::vector<uint64_t> hashes_;
+  std::vector<bool> dirty_;
+  std::vector<Rect> rects_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_SCREEN_TILE_DAMAGE_TRACKER_H
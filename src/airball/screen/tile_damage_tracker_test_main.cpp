@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "tile_damage_tracker.h"
+
+#define ASSERT_TRUE(x) if (!(x)) { std::cout << "Assertion failed " << __FILE__ << ":" << __LINE__ << std::endl; }
+
+constexpr int kWidth = 240;
+constexpr int kHeight = 320;
+constexpr int kTile = 16;
+constexpr int kStride = kWidth * sizeof(uint16_t);
+
+int main(int argc, char** argv) {
+  std::vector<uint16_t> frame(kWidth * kHeight, 0);
+  const auto* data = (const unsigned char*) frame.data();
+
+  airball::TileDamageTracker t(kWidth, kHeight, sizeof(uint16_t), kTile);
+
+  // The first frame is sent in full.
+  auto rects = t.update(data, kStride);
+  ASSERT_TRUE(rects.size() == 1);
+  ASSERT_TRUE(rects[0].x == 0 && rects[0].y == 0);
+  ASSERT_TRUE(rects[0].w == kWidth && rects[0].h == kHeight);
+
+  // An unchanged frame sends nothing.
+  rects = t.update(data, kStride);
+  ASSERT_TRUE(rects.empty());
+
+  // A single changed pixel sends the tile containing it.
+  frame[40 * kWidth + 50] = 0xffff;
+  rects = t.update(data, kStride);
+  ASSERT_TRUE(rects.size() == 1);
+  ASSERT_TRUE(rects[0].x == 48 && rects[0].y == 32);
+  ASSERT_TRUE(rects[0].w == kTile && rects[0].h == kTile);
+
+  // A change spanning several rows of tiles becomes one tall rectangle.
+  for (int y = 100; y < 150; y++) {
+    frame[y * kWidth + 20] = 0x1234;
+  }
+  rects = t.update(data, kStride);
+  ASSERT_TRUE(rects.size() == 1);
+  ASSERT_TRUE(rects[0].x == 16 && rects[0].y == 96);
+  ASSERT_TRUE(rects[0].w == kTile && rects[0].h == 4 * kTile);
+
+  // Changes far apart in the same tile row stay separate.
+  frame[5 * kWidth + 5] = 0x0001;
+  frame[5 * kWidth + 200] = 0x0001;
+  rects = t.update(data, kStride);
+  ASSERT_TRUE(rects.size() == 2);
+
+  // Changes separated by one clean tile are merged.
+  frame[5 * kWidth + 5] = 0x0002;
+  frame[5 * kWidth + 37] = 0x0002;
+  rects = t.update(data, kStride);
+  ASSERT_TRUE(rects.size() == 1);
+  ASSERT_TRUE(rects[0].x == 0 && rects[0].w == 3 * kTile);
+
+  // A mostly changed frame is sent in full.
+  for (auto& p : frame) {
+    p = 0x5555;
+  }
+  rects = t.update(data, kStride);
+  ASSERT_TRUE(rects.size() == 1);
+  ASSERT_TRUE(rects[0].w == kWidth && rects[0].h == kHeight);
+
+  // After a reset, the next frame is sent in full.
+  t.reset();
+  rects = t.update(data, kStride);
+  ASSERT_TRUE(rects.size() == 1);
+  ASSERT_TRUE(rects[0].w == kWidth && rects[0].h == kHeight);
+
+  return 0;
+}
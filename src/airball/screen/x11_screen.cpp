@@ -1,51 +1,177 @@
 #include "x11_screen.h"
 
-#include <cairo/cairo-xlib.h>
 #include <X11/X.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
+#include <iostream>
 #include <stdlib.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
 #include <math.h>
 
 namespace airball {
 
-X11Screen::X11Screen(const int width, const int height) {
-  Display* display = XOpenDisplay(nullptr);
-  Window w = XCreateSimpleWindow(display, DefaultRootWindow(display), 0, 0,
-                                 width, height, 0, 0, 0);
-  XSelectInput(display, w, StructureNotifyMask);
-  XMapWindow(display, w);
+// Set by the error handler installed while attaching shared memory, which
+// fails if the server is on another machine.
+static bool shm_error = false;
+
+static int shmErrorHandler(Display* display, XErrorEvent* event) {
+  shm_error = true;
+  return 0;
+}
+
+static cairo_format_t formatFor(const XImage* image) {
+  if (image->bits_per_pixel == 32 && image->red_mask == 0xff0000 &&
+      image->green_mask == 0xff00 && image->blue_mask == 0xff) {
+    return CAIRO_FORMAT_RGB24;
+  }
+  if (image->bits_per_pixel == 16 && image->red_mask == 0xf800 &&
+      image->green_mask == 0x07e0 && image->blue_mask == 0x001f) {
+    return CAIRO_FORMAT_RGB16_565;
+  }
+  return CAIRO_FORMAT_INVALID;
+}
+
+X11Screen::X11Screen(const int width, const int height)
+    : width_(width),
+      height_(height),
+      image_(nullptr),
+      use_shm_(false),
+      shminfo_({}),
+      completion_type_(-1) {
+  display_ = XOpenDisplay(nullptr);
+  if (display_ == nullptr) {
+    std::cerr << "Error: cannot open X display" << std::endl;
+    exit(-1);
+  }
+  window_ = XCreateSimpleWindow(display_, DefaultRootWindow(display_), 0, 0,
+                                width, height, 0, 0, 0);
+  XSelectInput(display_, window_, StructureNotifyMask);
+  XMapWindow(display_, window_);
+  gc_ = XCreateGC(display_, window_, 0, nullptr);
 
   // Wait for the MapNotify event
 
   for(;;) {
     XEvent e;
-    XNextEvent(display, &e);
+    XNextEvent(display_, &e);
     if (e.type == MapNotify) {
       break;
     }
   }
 
-  set_cs(cairo_xlib_surface_create(
-      display, w, DefaultVisual(display, DefaultScreen(display)), width, height));
-  cairo_xlib_surface_set_size(cs(), width, height);
+  const int screen = DefaultScreen(display_);
+  Visual* visual = DefaultVisual(display_, screen);
+  const int depth = DefaultDepth(display_, screen);
+  if (!attachShm(visual, depth)) {
+    createImage(visual, depth);
+  }
+
+  const cairo_format_t format = formatFor(image_);
+  if (format == CAIRO_FORMAT_INVALID ||
+      image_->bytes_per_line < cairo_format_stride_for_width(format, width) ||
+      image_->bytes_per_line % 4 != 0) {
+    std::cerr << "Error: unsupported X visual, depth " << depth << std::endl;
+    exit(-1);
+  }
+  set_cs(cairo_image_surface_create_for_data(
+      (unsigned char*) image_->data, format, width, height,
+      image_->bytes_per_line));
   set_cr(cairo_create(cs()));
 }
 
-void X11Screen::flush() {
-  Display *display = cairo_xlib_surface_get_display(cs());
-  while (XPending(display)) {
+bool X11Screen::attachShm(Visual* visual, int depth) {
+  if (!XShmQueryExtension(display_)) {
+    return false;
+  }
+  image_ = XShmCreateImage(display_, visual, depth, ZPixmap, nullptr,
+                           &shminfo_, width_, height_);
+  if (image_ == nullptr) {
+    return false;
+  }
+  shminfo_.shmid = shmget(IPC_PRIVATE, image_->bytes_per_line * image_->height,
+                          IPC_CREAT | 0600);
+  if (shminfo_.shmid == -1) {
+    XDestroyImage(image_);
+    image_ = nullptr;
+    return false;
+  }
+  shminfo_.shmaddr = image_->data = (char*) shmat(shminfo_.shmid, nullptr, 0);
+  shminfo_.readOnly = False;
+
+  shm_error = false;
+  XErrorHandler previous = XSetErrorHandler(shmErrorHandler);
+  XShmAttach(display_, &shminfo_);
+  XSync(display_, False);
+  XSetErrorHandler(previous);
+
+  // The segment is freed once both we and the server have detached from it,
+  // even if we exit without doing so.
+  shmctl(shminfo_.shmid, IPC_RMID, nullptr);
+
+  if (shm_error || shminfo_.shmaddr == (char*) -1) {
+    if (shminfo_.shmaddr != (char*) -1) {
+      shmdt(shminfo_.shmaddr);
+    }
+    image_->data = nullptr;
+    XDestroyImage(image_);
+    image_ = nullptr;
+    return false;
+  }
+  use_shm_ = true;
+  completion_type_ = XShmGetEventBase(display_) + ShmCompletion;
+  return true;
+}
+
+void X11Screen::createImage(Visual* visual, int depth) {
+  image_ = XCreateImage(display_, visual, depth, ZPixmap, 0, nullptr,
+                        width_, height_, 32, 0);
+  if (image_ == nullptr) {
+    std::cerr << "Error: cannot create X image" << std::endl;
+    exit(-1);
+  }
+  // Freed by XDestroyImage
+  image_->data = (char*) calloc(image_->bytes_per_line, height_);
+}
+
+void X11Screen::handleEvents(bool wait_for_completion) {
+  while (wait_for_completion || XPending(display_)) {
     XEvent ev;
-    XNextEvent(display, &ev);
+    XNextEvent(display_, &ev);
+    if (ev.type == completion_type_) {
+      wait_for_completion = false;
+    }
+  }
+}
+
+void X11Screen::flush() {
+  cairo_surface_flush(cs());
+  if (use_shm_) {
+    XShmPutImage(display_, window_, gc_, image_, 0, 0, 0, 0,
+                 width_, height_, True);
+    XFlush(display_);
+    // The server reads the image after the request returns, so the next
+    // frame must not be drawn until it says it is done.
+    handleEvents(true);
+  } else {
+    XPutImage(display_, window_, gc_, image_, 0, 0, 0, 0, width_, height_);
+    XFlush(display_);
+    handleEvents(false);
   }
-  XFlush(display);
 }
 
 X11Screen::~X11Screen() {
   cairo_destroy(cr());
-  Display *dsp = cairo_xlib_surface_get_display(cs());
   cairo_surface_destroy(cs());
-  XCloseDisplay(dsp);
+  if (use_shm_) {
+    XShmDetach(display_, &shminfo_);
+    XSync(display_, False);
+    shmdt(shminfo_.shmaddr);
+    image_->data = nullptr;
+  }
+  XDestroyImage(image_);
+  XFreeGC(display_, gc_);
+  XCloseDisplay(display_);
 }
 
 }  // namespace airball
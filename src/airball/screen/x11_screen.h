@@ -3,10 +3,20 @@
 
 #include <thread>
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
 #include "AbstractScreen.h"
 
 namespace airball {
 
+/**
+ * Encapsulates a Screen which paints into a window on an X server.
+ *
+ * Frames are drawn into a local image and sent to the window with one
+ * request per frame. The image is shared with the server using the MIT-SHM
+ * extension where possible, which saves copying it through the connection;
+ * otherwise it is sent with XPutImage.
+ */
 class X11Screen : public AbstractScreen {
 public:
   X11Screen(int width, int height);
@@ -16,6 +26,24 @@ public:
   void flush() override;
 
   void setBrightness(double value) override {}
+
+private:
+  bool attachShm(Visual* visual, int depth);
+  void createImage(Visual* visual, int depth);
+
+  // Handle any events, stopping early once the current frame has been
+  // copied out of shared memory if `wait_for_completion` is set.
+  void handleEvents(bool wait_for_completion);
+
+  const int width_;
+  const int height_;
+  Display* display_;
+  Window window_;
+  GC gc_;
+  XImage* image_;
+  bool use_shm_;
+  XShmSegmentInfo shminfo_;
+  int completion_type_;
 };
 
 
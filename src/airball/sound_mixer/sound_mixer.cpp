@@ -12,6 +12,7 @@ constexpr snd_pcm_uframes_t kDesiredPeriodSize = 512;
 sound_mixer::sound_mixer(const std::string& device_name)
     : device_name_(device_name),
       done_(false),
+      xruns_(0),
       handle_(nullptr),
       actual_rate_(kDesiredRate),
       actual_period_size_(kDesiredPeriodSize),
@@ -55,6 +56,14 @@ void sound_mixer::loop() {
     }
 
     int n = snd_pcm_writei(handle_, buf.get(), actual_period_size_);
+    if (n == -EPIPE) {
+      xruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (n < 0) {
+      // Restart the stream after an underrun or a suspend, rather than
+      // failing every write from then on.
+      n = snd_pcm_recover(handle_, n, 1 /* silent */);
+    }
     if (n < 0) {
       std:: cerr << snd_strerror(n) << " " << std::flush;
     }
@@ -123,6 +132,10 @@ snd_pcm_uframes_t sound_mixer::frequency_to_period(double cycles_per_second) {
   return seconds_to_frames(1.0 / cycles_per_second);
 }
 
+unsigned long sound_mixer::xruns() const {
+  return xruns_.load(std::memory_order_relaxed);
+}
+
 snd_pcm_uframes_t sound_mixer::octaves_to_period(
     double base_cycles_per_second,
     double octaves) {
@@ -5,6 +5,7 @@
 #include <condition_variable>
 #define ALSA_PCM_NEW_HW_PARAMS_API
 #include <alsa/asoundlib.h>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -31,6 +32,8 @@ public:
   snd_pcm_uframes_t octaves_to_period(double base_cycles_per_second,
                                       double octaves) override;
 
+  unsigned long xruns() const override;
+
 private:
   unsigned int actual_rate();
 
@@ -47,6 +50,8 @@ private:
   std::condition_variable start_;
   bool done_;
 
+  std::atomic<unsigned long> xruns_;
+
   std::thread server_;
 
   snd_pcm_t* handle_;
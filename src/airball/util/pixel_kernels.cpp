@@ -0,0 +1,232 @@
+#include "pixel_kernels.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace airball {
+
+// The side of the square tiles the rotation works through, chosen so that a
+// tile of the source and of the destination both stay in the L1 cache.
+constexpr int kTile = 32;
+
+template <typename T>
+static inline void rotatePixels(
+    const uint8_t* src, int src_stride,
+    uint8_t* dst, int dst_stride,
+    int width,
+    int x0, int x1, int y0, int y1) {
+  for (int y = y0; y < y1; y++) {
+    const T* s = (const T*) (src + (long) y * src_stride);
+    for (int x = x0; x < x1; x++) {
+      ((T*) (dst + (long) (width - 1 - x) * dst_stride))[y] = s[x];
+    }
+  }
+}
+
+// Transposes an N x N block of pixels: column k of the source becomes row k
+// of the destination. The destination stride is negative, so that rows are
+// written upwards, which makes the transpose a rotation.
+struct Transpose4x32 {
+  static constexpr int N = 4;
+  static inline void apply(
+      const uint8_t* src, int src_stride, uint8_t* dst, long dst_stride) {
+#if defined(__SSE2__)
+    const __m128i r0 = _mm_loadu_si128((const __m128i*) src);
+    const __m128i r1 = _mm_loadu_si128((const __m128i*) (src + src_stride));
+    const __m128i r2 = _mm_loadu_si128((const __m128i*) (src + 2 * src_stride));
+    const __m128i r3 = _mm_loadu_si128((const __m128i*) (src + 3 * src_stride));
+    const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    const __m128i t1 = _mm_unpackhi_epi32(r0, r1);
+    const __m128i t2 = _mm_unpacklo_epi32(r2, r3);
+    const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+    _mm_storeu_si128((__m128i*) dst, _mm_unpacklo_epi64(t0, t2));
+    _mm_storeu_si128((__m128i*) (dst + dst_stride), _mm_unpackhi_epi64(t0, t2));
+    _mm_storeu_si128((__m128i*) (dst + 2 * dst_stride), _mm_unpacklo_epi64(t1, t3));
+    _mm_storeu_si128((__m128i*) (dst + 3 * dst_stride), _mm_unpackhi_epi64(t1, t3));
+#elif defined(__ARM_NEON)
+    const uint32x4_t r0 = vld1q_u32((const uint32_t*) src);
+    const uint32x4_t r1 = vld1q_u32((const uint32_t*) (src + src_stride));
+    const uint32x4_t r2 = vld1q_u32((const uint32_t*) (src + 2 * src_stride));
+    const uint32x4_t r3 = vld1q_u32((const uint32_t*) (src + 3 * src_stride));
+    const uint32x4x2_t p01 = vtrnq_u32(r0, r1);
+    const uint32x4x2_t p23 = vtrnq_u32(r2, r3);
+    vst1q_u32((uint32_t*) dst,
+              vcombine_u32(vget_low_u32(p01.val[0]), vget_low_u32(p23.val[0])));
+    vst1q_u32((uint32_t*) (dst + dst_stride),
+              vcombine_u32(vget_low_u32(p01.val[1]), vget_low_u32(p23.val[1])));
+    vst1q_u32((uint32_t*) (dst + 2 * dst_stride),
+              vcombine_u32(vget_high_u32(p01.val[0]), vget_high_u32(p23.val[0])));
+    vst1q_u32((uint32_t*) (dst + 3 * dst_stride),
+              vcombine_u32(vget_high_u32(p01.val[1]), vget_high_u32(p23.val[1])));
+#else
+    for (int k = 0; k < N; k++) {
+      uint32_t* d = (uint32_t*) (dst + k * dst_stride);
+      for (int j = 0; j < N; j++) {
+        d[j] = ((const uint32_t*) (src + j * src_stride))[k];
+      }
+    }
+#endif
+  }
+};
+
+struct Transpose8x16 {
+  static constexpr int N = 8;
+  static inline void apply(
+      const uint8_t* src, int src_stride, uint8_t* dst, long dst_stride) {
+#if defined(__SSE2__)
+    __m128i r[8];
+    for (int j = 0; j < 8; j++) {
+      r[j] = _mm_loadu_si128((const __m128i*) (src + j * src_stride));
+    }
+    // Pairs of rows, interleaved a pixel at a time.
+    const __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+    const __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+    const __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+    const __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+    const __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+    const __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+    const __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+    const __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+    // Two columns of four rows each.
+    const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+    const __m128i c[8] = {
+        _mm_unpacklo_epi64(b0, b4), _mm_unpackhi_epi64(b0, b4),
+        _mm_unpacklo_epi64(b1, b5), _mm_unpackhi_epi64(b1, b5),
+        _mm_unpacklo_epi64(b2, b6), _mm_unpackhi_epi64(b2, b6),
+        _mm_unpacklo_epi64(b3, b7), _mm_unpackhi_epi64(b3, b7),
+    };
+    for (int k = 0; k < 8; k++) {
+      _mm_storeu_si128((__m128i*) (dst + k * dst_stride), c[k]);
+    }
+#elif defined(__ARM_NEON)
+    uint16x8_t r[8];
+    for (int j = 0; j < 8; j++) {
+      r[j] = vld1q_u16((const uint16_t*) (src + j * src_stride));
+    }
+    // Pairs of rows, with even and odd columns apart.
+    const uint16x8x2_t q01 = vtrnq_u16(r[0], r[1]);
+    const uint16x8x2_t q23 = vtrnq_u16(r[2], r[3]);
+    const uint16x8x2_t q45 = vtrnq_u16(r[4], r[5]);
+    const uint16x8x2_t q67 = vtrnq_u16(r[6], r[7]);
+    // Columns k and k + 4 of four rows each.
+    const uint32x4x2_t s0 = vtrnq_u32(
+        vreinterpretq_u32_u16(q01.val[0]), vreinterpretq_u32_u16(q23.val[0]));
+    const uint32x4x2_t s1 = vtrnq_u32(
+        vreinterpretq_u32_u16(q01.val[1]), vreinterpretq_u32_u16(q23.val[1]));
+    const uint32x4x2_t s2 = vtrnq_u32(
+        vreinterpretq_u32_u16(q45.val[0]), vreinterpretq_u32_u16(q67.val[0]));
+    const uint32x4x2_t s3 = vtrnq_u32(
+        vreinterpretq_u32_u16(q45.val[1]), vreinterpretq_u32_u16(q67.val[1]));
+    const uint32x4_t c[8] = {
+        vcombine_u32(vget_low_u32(s0.val[0]), vget_low_u32(s2.val[0])),
+        vcombine_u32(vget_low_u32(s1.val[0]), vget_low_u32(s3.val[0])),
+        vcombine_u32(vget_low_u32(s0.val[1]), vget_low_u32(s2.val[1])),
+        vcombine_u32(vget_low_u32(s1.val[1]), vget_low_u32(s3.val[1])),
+        vcombine_u32(vget_high_u32(s0.val[0]), vget_high_u32(s2.val[0])),
+        vcombine_u32(vget_high_u32(s1.val[0]), vget_high_u32(s3.val[0])),
+        vcombine_u32(vget_high_u32(s0.val[1]), vget_high_u32(s2.val[1])),
+        vcombine_u32(vget_high_u32(s1.val[1]), vget_high_u32(s3.val[1])),
+    };
+    for (int k = 0; k < 8; k++) {
+      vst1q_u16((uint16_t*) (dst + k * dst_stride), vreinterpretq_u16_u32(c[k]));
+    }
+#else
+    for (int k = 0; k < N; k++) {
+      uint16_t* d = (uint16_t*) (dst + k * dst_stride);
+      for (int j = 0; j < N; j++) {
+        d[j] = ((const uint16_t*) (src + j * src_stride))[k];
+      }
+    }
+#endif
+  }
+};
+
+template <typename T, typename Block>
+static void rotateCounterclockwise(
+    const uint8_t* src, int src_stride,
+    uint8_t* dst, int dst_stride,
+    int width, int height) {
+  constexpr int N = Block::N;
+  for (int ty = 0; ty < height; ty += kTile) {
+    const int y_end = std::min(ty + kTile, height);
+    for (int tx = 0; tx < width; tx += kTile) {
+      const int x_end = std::min(tx + kTile, width);
+      int y = ty;
+      for (; y + N <= y_end; y += N) {
+        int x = tx;
+        for (; x + N <= x_end; x += N) {
+          Block::apply(
+              src + (long) y * src_stride + x * sizeof(T), src_stride,
+              dst + (long) (width - 1 - x) * dst_stride + y * sizeof(T),
+              -(long) dst_stride);
+        }
+        rotatePixels<T>(src, src_stride, dst, dst_stride, width, x, x_end, y, y + N);
+      }
+      rotatePixels<T>(src, src_stride, dst, dst_stride, width, tx, x_end, y, y_end);
+    }
+  }
+}
+
+void rotateCounterclockwise32(
+    const uint8_t* src, int src_stride,
+    uint8_t* dst, int dst_stride,
+    int width, int height) {
+  rotateCounterclockwise<uint32_t, Transpose4x32>(
+      src, src_stride, dst, dst_stride, width, height);
+}
+
+void rotateCounterclockwise16(
+    const uint8_t* src, int src_stride,
+    uint8_t* dst, int dst_stride,
+    int width, int height) {
+  rotateCounterclockwise<uint16_t, Transpose8x16>(
+      src, src_stride, dst, dst_stride, width, height);
+}
+
+void scaleBytes(
+    uint8_t* data, int stride,
+    int width, int height,
+    int factor) {
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i f = _mm_set1_epi16((short) factor);
+#elif defined(__ARM_NEON)
+  const uint8x8_t f = vdup_n_u8((uint8_t) factor);
+#endif
+  for (int y = 0; y < height; y++) {
+    uint8_t* row = data + (long) y * stride;
+    int x = 0;
+#if defined(__SSE2__)
+    for (; x + 16 <= width; x += 16) {
+      const __m128i v = _mm_loadu_si128((const __m128i*) (row + x));
+      const __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), f), 8);
+      const __m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), f), 8);
+      _mm_storeu_si128((__m128i*) (row + x), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(__ARM_NEON)
+    for (; x + 16 <= width; x += 16) {
+      const uint8x16_t v = vld1q_u8(row + x);
+      const uint8x8_t lo = vshrn_n_u16(vmull_u8(vget_low_u8(v), f), 8);
+      const uint8x8_t hi = vshrn_n_u16(vmull_u8(vget_high_u8(v), f), 8);
+      vst1q_u8(row + x, vcombine_u8(lo, hi));
+    }
+#endif
+    for (; x < width; x++) {
+      row[x] = (uint8_t) ((row[x] * factor) >> 8);
+    }
+  }
+}
+
+}  // namespace airball
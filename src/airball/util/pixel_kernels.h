@@ -0,0 +1,32 @@
+#ifndef AIRBALL_UTIL_PIXEL_KERNELS_H
+#define AIRBALL_UTIL_PIXEL_KERNELS_H
+
+#include <cstdint>
+
+namespace airball {
+
+// Rotate an image of 32 bit pixels a quarter turn counterclockwise. The pixel
+// at (x, y) of the width x height source lands at (y, width - 1 - x) of the
+// height x width destination. Strides are in bytes, as Cairo gives them.
+void rotateCounterclockwise32(
+    const uint8_t* src, int src_stride,
+    uint8_t* dst, int dst_stride,
+    int width, int height);
+
+// The same, for 16 bit pixels.
+void rotateCounterclockwise16(
+    const uint8_t* src, int src_stride,
+    uint8_t* dst, int dst_stride,
+    int width, int height);
+
+// Scale each of the width x height bytes of an image of 8 bit values by
+// factor / 256, rounding down, so that repeated scaling always reaches zero.
+// The factor must be less than 256.
+void scaleBytes(
+    uint8_t* data, int stride,
+    int width, int height,
+    int factor);
+
+}  // namespace airball
+
+#endif  // AIRBALL_UTIL_PIXEL_KERNELS_H
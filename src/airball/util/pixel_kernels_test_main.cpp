@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "pixel_kernels.h"
+
+#define ASSERT_TRUE(x) if (!(x)) { std::cout << "Assertion failed " << __FILE__ << ":" << __LINE__ << std::endl; }
+
+template <typename T>
+bool rotatesCorrectly(
+    void (*rotate)(const uint8_t*, int, uint8_t*, int, int, int),
+    int width,
+    int height) {
+  // Rows padded past their pixels, as Cairo may do.
+  const int src_stride = (width + 3) * sizeof(T);
+  const int dst_stride = (height + 5) * sizeof(T);
+  std::vector<T> src(src_stride / sizeof(T) * height);
+  std::vector<T> dst(dst_stride / sizeof(T) * width, 0);
+  for (size_t i = 0; i < src.size(); i++) {
+    src[i] = (T) (i * 2654435761u);
+  }
+  rotate((const uint8_t*) src.data(), src_stride,
+         (uint8_t*) dst.data(), dst_stride,
+         width, height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if (dst[(width - 1 - x) * dst_stride / sizeof(T) + y] !=
+          src[y * src_stride / sizeof(T) + x]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool scalesCorrectly(int width, int height, int factor) {
+  const int stride = width + 7;
+  std::vector<uint8_t> data(stride * height);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (uint8_t) (i * 37);
+  }
+  std::vector<uint8_t> original = data;
+  airball::scaleBytes(data.data(), stride, width, height, factor);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < stride; x++) {
+      const int i = y * stride + x;
+      // Padding past the end of each row is left alone.
+      const int expected = x < width ? (original[i] * factor) >> 8 : original[i];
+      if (data[i] != expected) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int arg, char** argv) {
+  const int sizes[][2] = {
+      {1, 1}, {4, 4}, {8, 8}, {7, 9}, {33, 65}, {272, 480}, {480, 272},
+  };
+  for (const auto& s : sizes) {
+    ASSERT_TRUE(rotatesCorrectly<uint32_t>(
+        airball::rotateCounterclockwise32, s[0], s[1]));
+    ASSERT_TRUE(rotatesCorrectly<uint16_t>(
+        airball::rotateCounterclockwise16, s[0], s[1]));
+    ASSERT_TRUE(scalesCorrectly(s[0], s[1], 219));
+  }
+  ASSERT_TRUE(scalesCorrectly(100, 3, 0));
+  ASSERT_TRUE(scalesCorrectly(100, 3, 255));
+
+  // Repeated scaling fades everything to nothing.
+  std::vector<uint8_t> row(40, 255);
+  for (int i = 0; i < 64; i++) {
+    airball::scaleBytes(row.data(), 40, 40, 1, 219);
+  }
+  ASSERT_TRUE(row[0] == 0 && row[39] == 0);
+}
@@ -0,0 +1,56 @@
+#include "thread_pool.h"
+
+namespace airball {
+
+ThreadPool::ThreadPool(int num_threads)
+    : pending_(0),
+      stopping_(false) {
+  for (int i = 0; i < num_threads; i++) {
+    threads_.emplace_back([this]() { run(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto& t : threads_) {
+    t.join();
+  }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    tasks_.push_back(std::move(task));
+    pending_++;
+  }
+  cv_.notify_all();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(mu_);
+  cv_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+void ThreadPool::run() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+    if (tasks_.empty()) {
+      // Stopping, with every task already run.
+      return;
+    }
+    std::function<void()> task = std::move(tasks_.front());
+    tasks_.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+    pending_--;
+    cv_.notify_all();
+  }
+}
+
+}  // namespace airball
@@ -0,0 +1,60 @@
+#ifndef AIRBALL_UTIL_THREAD_POOL_H
+#define AIRBALL_UTIL_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace airball {
+
+/**
+ * A fixed set of threads that run functions given to them, in the order
+ * given, as threads become free.
+ */
+class ThreadPool {
+public:
+  /**
+   * Create a new ThreadPool.
+   *
+   * @param num_threads the number of threads.
+   */
+  explicit ThreadPool(int num_threads);
+
+  /**
+   * Wait for all the functions given to finish, then stop the threads.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Arrange for a function to be run on one of the threads.
+   */
+  void submit(std::function<void()> task);
+
+  /**
+   * Wait until every function given so far has finished.
+   */
+  void wait();
+
+  int size() const { return threads_.size(); }
+
+private:
+  void run();
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  // The number of functions given that have not yet finished.
+  int pending_;
+  bool stopping_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_UTIL_THREAD_POOL_H
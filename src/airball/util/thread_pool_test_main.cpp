@@ -0,0 +1,36 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+#include "thread_pool.h"
+
+#define ASSERT_TRUE(x) if (!(x)) { std::cout << "Assertion failed " << __FILE__ << ":" << __LINE__ << std::endl; }
+
+int main(int arg, char** argv) {
+  std::atomic<int> count(0);
+
+  {
+    airball::ThreadPool pool(4);
+    ASSERT_TRUE(pool.size() == 4);
+
+    for (int i = 0; i < 100; i++) {
+      pool.submit([&count]() { count++; });
+    }
+    pool.wait();
+    ASSERT_TRUE(count == 100);
+
+    // Waiting with nothing outstanding returns at once.
+    pool.wait();
+    ASSERT_TRUE(count == 100);
+
+    for (int i = 0; i < 10; i++) {
+      pool.submit([&count]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        count++;
+      });
+    }
+  }
+
+  // Destroying the pool runs everything that was given to it.
+  ASSERT_TRUE(count == 110);
+}
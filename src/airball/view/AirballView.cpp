@@ -1,8 +1,20 @@
 #include "AirballView.h"
 
+#include <charconv>
+#include <chrono>
 #include <math.h>
-#include <sstream>
+#include "../../framework/FrameStats.h"
+#include "../../framework/QualityGovernor.h"
+#include "../../framework/StageTimers.h"
+#include "../util/thread_pool.h"
 #include "../util/units.h"
+#include "cached_layer.h"
+#include "cached_text.h"
+#include "display_list.h"
+#include "glyph_atlas.h"
+#include "phosphor_trail.h"
+#include "sprite_cache.h"
+#include "upright_frame.h"
 #include "widgets.h"
 
 namespace airball {
@@ -10,335 +22,619 @@ namespace airball {
 constexpr double kMetersPerFoot = 0.3048;
 constexpr double kSecondsPerMinute = 60;
 
-class PaintCycle {
+// The geometry, colors, strokes and fonts of the display, all derived from
+// the settings. A Layout is computed when the settings change and is then
+// shared by each PaintCycle until they change again.
+class Layout {
 public:
-  PaintCycle(const IAirballModel &model, IScreen *screen)
-      : model_(model), screen_(screen) {}
-
-  void paint();
+  explicit Layout(const ISettings* settings);
 
-private:
   struct VsiStep {
     double fpm;
     double thick;
   };
 
-  void layout();
-  void paintBackground();
-  void paintRawAirballs();
-  void paintRawAirball(
-      const Point& center,
-      const double radius,
-      const double bright);
-  void paintSmoothAirball();
-  void paintAirballLowAirspeed(const Point& center);
-  void paintAirballAirspeed(const Point& center, const double radius);
-  void paintAirballAirspeedLimits(const Point& center);
-  void paintAirballAirspeedLimitsNormal(const Point& center);
-  void paintAirballAirspeedLimitsRotate(const Point& center);
-  void paintAirballTrueAirspeed(const Point& center);
-  void paintTotemPole();
-  void paintTotemPoleLine();
-  void paintTotemPoleAlphaX();
-  void paintTotemPoleAlphaY();
-  void paintCowCatcher();
-  void paintVsi();
-  void paintVsiTicMarks(
-      Point top_left,
-      Point top_right,
-      Point center_left,
-      Point center_right,
-      Point bottom_left,
-      Point bottom_right,
-      double radians_per_fpm);
-  void paintVsiPointer(
-      Point top_left,
-      Point top_right,
-      Point center_left,
-      Point center_right,
-      Point bottom_left,
-      Point bottom_right,
-      double radians_per_fpm);
-  void paintAltitude(
-      Point top_left,
-      Point top_right,
-      Point center_left,
-      Point center_right,
-      Point bottom_left,
-      Point bottom_right);
-  void paintBaroSetting(
-      Point top_left,
-      Point top_right,
-      Point center_left,
-      Point center_right,
-      Point bottom_left,
-      Point bottom_right);
-  void paintNoFlightData();
-  void paintUnitsAnnotation();
-  void paintAdjusting();
-
-  double alpha_to_y(const double alpha);
-  double beta_to_x(const double beta);
-
-  double alpha_degrees_to_y(const double alpha_degrees);
-  double beta_degrees_to_x(const double beta_degrees);
-
-  double airspeed_to_display_units(const double airspeed);
-  double airspeed_to_radius(const double airspeed);
-  double airspeed_display_units_to_radius(const double airspeed_display_units);
-
-  const IAirballModel &model_;
-  IScreen *screen_;
+  std::string fontName;
+  double width;
+  double height;
+  double altimeterHeight;
+  double cowCatcherHeight;
+  double airballHeight;
+  double displayMargin;
+  double displayXMid;
+  double displayRegionWidth;
+  double displayRegionHalfWidth;
+  double speedLimitsRosetteHalfAngle;
+  double trueAirspeedRosetteHalfAngle;
+  double alphaRefRadius;
+  double alphaRefGapDegrees;
+  double lowSpeedThresholdAirballRadius;
+  double alphaRefTopAngle0;
+  double alphaRefTopAngle1;
+  double alphaRefBotAngle0;
+  double alphaRefBotAngle1;
+  double totemPoleAlphaUnit;
+  double statusRegionMargin;
+  double adjustingRegionMargin;
+  int numCowCatcherLines;
+  Color background;
+  Color airballFill;
+  double rawAirballsMaxBrightness;
+  Stroke airballCrosshairsStroke;
+  double lowSpeedAirballStrokeWidth;
+  Color tasRingColor;
+  double tasRingStrokeWidth;
+  double tasThresholdRatio;
+  Stroke lowSpeedAirballStroke;
+  double lowSpeedAirballArcRadius;
+  Stroke totemPoleStroke;
+  Stroke cowCatcherStroke;
+  Stroke vfeStroke;
+  Stroke vnoStroke;
+  Stroke vneStroke;
+  Stroke vBackgroundStroke;
+  double iASTextFontSize;
+  Font iASTextFont;
+  double iASTextMargin;
+  Color iASTextColor;
+  Stroke noFlightDataStroke;
+  Font statusTextFont;
+  Color statusTextColor;
+  Font adjustingTextFont;
+  Color adjustingTextColor;
+  Color linkColor;
+  double vsiHeight;
+  std::vector<VsiStep> vsiStepsFpm;
+  double vsiRadiansPerFpm;
+  double vsiTickLength;
+  double vsiKneeOffset;
+  Stroke vsiTickStrokeThin;
+  Stroke vsiPointerStroke;
+  Font altimeterFontLarge;
+  Font altimeterFontSmall;
+  Color altimeterTextColor;
+  Color altimeterBackgroundColor;
+  double altimeterBaselineRatio;
+  double altimeterNumberGap;
+  double baroLeftOffset;
+  Font baroFontSmall;
+  Color baroTextColor;
+
+  // Text that depends only on the settings.
+  std::string unitsAnnotation;
+  std::string adjustmentName;
+  std::string adjustmentValue;
+  std::string baroSettingText;
+
+  // Maps a raw ball to the display as alpha_to_y(), beta_to_x() and
+  // airspeed_to_radius() do, written as affine functions of the raw values
+  // so that a whole history of balls can be mapped in one pass.
+  struct BallTransform {
+    float xPerBeta;
+    float x0;
+    float yPerAlpha;
+    float y0;
+    float radiusPerIas;
+  };
+  BallTransform ballTransform;
 
+private:
   constexpr double ce_floor(double x) {
     return static_cast<double>(static_cast<int64_t>(x));
   }
-
-  std::string fontName_;
-  double width_;
-  double height_;
-  double altimeterHeight_;
-  double cowCatcherHeight_;
-  double airballHeight_;
-  double displayMargin_;
-  double displayXMid_;
-  double displayRegionWidth_;
-  double displayRegionHalfWidth_;
-  double speedLimitsRosetteHalfAngle_;
-  double trueAirspeedRosetteHalfAngle_;
-  double alphaRefRadius_;
-  double alphaRefGapDegrees_;
-  double lowSpeedThresholdAirballRadius_;
-  double alphaRefTopAngle0_;
-  double alphaRefTopAngle1_;
-  double alphaRefBotAngle0_;
-  double alphaRefBotAngle1_;
-  double totemPoleAlphaUnit_;
-  double statusRegionMargin_;
-  double adjustingRegionMargin_;
-  int numCowCatcherLines_;
-  Color background_;
-  Color airballFill_;
-  double rawAirballsMaxBrightness_;
-  Stroke airballCrosshairsStroke_;
-  double lowSpeedAirballStrokeWidth_;
-  Color tasRingColor_;
-  double tasRingStrokeWidth_;
-  double tasThresholdRatio_;
-  Stroke lowSpeedAirballStroke_;
-  double lowSpeedAirballArcRadius_;
-  Stroke totemPoleStroke_;
-  Stroke cowCatcherStroke_;
-  Stroke vfeStroke_;
-  Stroke vnoStroke_;
-  Stroke vneStroke_;
-  Stroke vBackgroundStroke_;
-  double iASTextFontSize_;
-  Font iASTextFont_;
-  double iASTextMargin_;
-  Color iASTextColor_;
-  int printBufSize_;
-  Stroke noFlightDataStroke_;
-  Font statusTextFont_;
-  Color statusTextColor_;
-  Font adjustingTextFont_;
-  Color adjustingTextColor_;
-  Color linkColor_;
-  double vsiHeight_;
-  std::vector<VsiStep> vsiStepsFpm_;
-  double vsiTickLength_;
-  double vsiKneeOffset_;
-  Stroke vsiTickStrokeThin_;
-  Stroke vsiPointerStroke_;
-  Font altimeterFontLarge_;
-  Font altimeterFontSmall_;
-  Color altimeterTextColor_;
-  Color altimeterBackgroundColor_;
-  double altimeterBaselineRatio_;
-  double altimeterNumberGap_;
-  double baroLeftOffset_;
-  Font baroFontSmall_;
-  Color baroTextColor_;
 };
 
-void AirballView::paint(const IAirballModel &m, IScreen *screen) {
-  PaintCycle(m, screen).paint();
-}
-
-void PaintCycle::layout() {
-  fontName_ = std::string("Noto Sans");
+Layout::Layout(const ISettings* settings) {
+  fontName = std::string("Noto Sans");
 
-  width_ = model_.settings()->screen_width();
-  height_ = model_.settings()->screen_height();
+  width = settings->screen_width();
+  height = settings->screen_height();
 
-  if (model_.settings()->show_altimeter()) {
-    altimeterHeight_ = 40;
-    airballHeight_ = height_ - altimeterHeight_;
+  if (settings->show_altimeter()) {
+    altimeterHeight = 40;
+    airballHeight = height - altimeterHeight;
   } else {
-    altimeterHeight_ = 0;
-    airballHeight_ = height_;
+    altimeterHeight = 0;
+    airballHeight = height;
   }
 
-  cowCatcherHeight_ = 24;
+  cowCatcherHeight = 24;
 
-  displayMargin_ = 3;
+  displayMargin = 3;
 
-  displayXMid_ = ce_floor(width_ / 2.0);
+  displayXMid = ce_floor(width / 2.0);
 
-  displayRegionWidth_ = width_;
-  displayRegionHalfWidth_ = displayRegionWidth_ / 2;
+  displayRegionWidth = width;
+  displayRegionHalfWidth = displayRegionWidth / 2;
 
-  speedLimitsRosetteHalfAngle_  = (15.0 / 2 / 180 * M_PI);
-  trueAirspeedRosetteHalfAngle_ = (70.0 / 2 / 180 * M_PI);
+  speedLimitsRosetteHalfAngle  = (15.0 / 2 / 180 * M_PI);
+  trueAirspeedRosetteHalfAngle = (70.0 / 2 / 180 * M_PI);
 
-  alphaRefRadius_ = 20;
+  alphaRefRadius = 20;
 
-  alphaRefGapDegrees_ = 40;
+  alphaRefGapDegrees = 40;
 
-  lowSpeedThresholdAirballRadius_ = 0.05 * (width_ / 2.0);
+  lowSpeedThresholdAirballRadius = 0.05 * (width / 2.0);
 
-  alphaRefTopAngle0_ = M_PI + (alphaRefGapDegrees_ / 2 / 180 * M_PI);
-  alphaRefTopAngle1_ =      - (alphaRefGapDegrees_ / 2 / 180 * M_PI);
+  alphaRefTopAngle0 = M_PI + (alphaRefGapDegrees / 2 / 180 * M_PI);
+  alphaRefTopAngle1 =      - (alphaRefGapDegrees / 2 / 180 * M_PI);
 
-  alphaRefBotAngle0_ =        (alphaRefGapDegrees_ / 2 / 180 * M_PI);
-  alphaRefBotAngle1_ = M_PI - (alphaRefGapDegrees_ / 2 / 180 * M_PI);
+  alphaRefBotAngle0 =        (alphaRefGapDegrees / 2 / 180 * M_PI);
+  alphaRefBotAngle1 = M_PI - (alphaRefGapDegrees / 2 / 180 * M_PI);
 
-  totemPoleAlphaUnit_ = 20;
+  totemPoleAlphaUnit = 20;
 
-  numCowCatcherLines_ = 4;
+  numCowCatcherLines = 4;
 
-  background_= Color(0, 0, 0);
+  background= Color(0, 0, 0);
 
-  airballFill_ = Color(255, 255, 255);
+  airballFill = Color(255, 255, 255);
 
-  rawAirballsMaxBrightness_ = 0.75;
+  rawAirballsMaxBrightness = 0.75;
 
-  airballCrosshairsStroke_ = Stroke(
+  airballCrosshairsStroke = Stroke(
       Color(128, 128, 128),
       2);
 
-  lowSpeedAirballStrokeWidth_ = 4.0;
+  lowSpeedAirballStrokeWidth = 4.0;
 
-  tasRingColor_ = Color(255, 0, 255);
+  tasRingColor = Color(255, 0, 255);
 
-  tasRingStrokeWidth_ = 3.0;
+  tasRingStrokeWidth = 3.0;
 
-  tasThresholdRatio_ = 0.25;
+  tasThresholdRatio = 0.25;
 
-  lowSpeedAirballStroke_ = Stroke(
+  lowSpeedAirballStroke = Stroke(
       Color(255, 255, 255),
-      lowSpeedAirballStrokeWidth_);
+      lowSpeedAirballStrokeWidth);
 
-  lowSpeedAirballArcRadius_ =
-      lowSpeedThresholdAirballRadius_ - lowSpeedAirballStrokeWidth_ / 2.0;
+  lowSpeedAirballArcRadius =
+      lowSpeedThresholdAirballRadius - lowSpeedAirballStrokeWidth / 2.0;
 
-  totemPoleStroke_ = Stroke(
+  totemPoleStroke = Stroke(
       Color(255, 255, 0),
       3);
 
-  cowCatcherStroke_ = Stroke(
+  cowCatcherStroke = Stroke(
       Color(255, 0, 0),
       3);
 
-  vfeStroke_ = Stroke(
+  vfeStroke = Stroke(
       Color(255, 255, 255),
       3);
 
-  vnoStroke_ = Stroke(
+  vnoStroke = Stroke(
       Color(255, 255, 0),
       3);
 
-  vneStroke_ = Stroke(
+  vneStroke = Stroke(
       Color(255, 0, 0),
       3);
 
-  vBackgroundStroke_ = Stroke(
+  vBackgroundStroke = Stroke(
       Color(0, 0, 0),
       6);
 
-  iASTextFontSize_ =
-      width_ / 6.0;
+  iASTextFontSize =
+      width / 6.0;
 
-  iASTextFont_ = Font(
-      fontName_,
-      iASTextFontSize_);
+  iASTextFont = Font(
+      fontName,
+      iASTextFontSize);
 
-  iASTextMargin_ =
+  iASTextMargin =
       8;
 
-  iASTextColor_ = Color(0, 0, 0);
+  iASTextColor = Color(0, 0, 0);
 
-  printBufSize_ = 128;
-
-  noFlightDataStroke_ = Stroke(
+  noFlightDataStroke = Stroke(
       Color(255, 0, 0),
       3);
 
-  statusTextFont_ = Font(fontName_, 12);
-  statusTextColor_ = Color(255, 255, 255);
+  statusTextFont = Font(fontName, 12);
+  statusTextColor = Color(255, 255, 255);
 
-  adjustingTextFont_ = Font(fontName_, 24);
-  adjustingTextColor_ = Color(255, 255, 255);
+  adjustingTextFont = Font(fontName, 24);
+  adjustingTextColor = Color(255, 255, 255);
 
-  linkColor_ = Color(0, 180, 180);
+  linkColor = Color(0, 180, 180);
 
-  vsiHeight_ = altimeterHeight_ - 2 * displayMargin_;
+  vsiHeight = altimeterHeight - 2 * displayMargin;
 
-  vsiStepsFpm_.clear();
-  vsiStepsFpm_.push_back(
+    vsiStepsFpm.push_back(
       {
           .fpm = 500,
           .thick = 1,
       });
-  vsiStepsFpm_.push_back(
+  vsiStepsFpm.push_back(
       {
           .fpm = 1000,
           .thick = 2,
       });
-  vsiStepsFpm_.push_back(
+  vsiStepsFpm.push_back(
       {
           .fpm = 1500,
           .thick = 1,
       });
-  vsiStepsFpm_.push_back(
+  vsiStepsFpm.push_back(
       {
           .fpm = 2000,
           .thick = 2,
       });
-  vsiStepsFpm_.push_back(
+  vsiStepsFpm.push_back(
       {
           .fpm = 3000,
           .thick = 2,
       });
 
-  vsiTickLength_ = 7;
-  vsiKneeOffset_ = 3;
-  vsiTickStrokeThin_ = Stroke(
+  vsiRadiansPerFpm = atan(vsiHeight / 2 / width) / vsiStepsFpm[0].fpm;
+
+  vsiTickLength = 7;
+  vsiKneeOffset = 3;
+  vsiTickStrokeThin = Stroke(
       Color(255, 255, 255),
       2);
-  vsiPointerStroke_ = Stroke(
+  vsiPointerStroke = Stroke(
       Color(255, 0, 255),
       4);
-  altimeterFontLarge_ = Font(
-      fontName_,
-      width_ / 8);
-  altimeterFontSmall_ = Font(
-      fontName_,
-      width_ / 12);
-  altimeterTextColor_= Color(255, 255, 255);
-  altimeterBackgroundColor_ = Color(64, 64, 64);
-  altimeterBaselineRatio_ = 0.75;
-  altimeterNumberGap_ = 7;
-
-  statusRegionMargin_ = 5;
-  adjustingRegionMargin_ = 10;
-
-  baroLeftOffset_ =
-      width_ / 12;
-  baroFontSmall_ = Font(
-      fontName_,
-      width_ / 20);
-  baroTextColor_ = Color(255, 255, 255);
+  altimeterFontLarge = Font(
+      fontName,
+      width / 8);
+  altimeterFontSmall = Font(
+      fontName,
+      width / 12);
+  altimeterTextColor= Color(255, 255, 255);
+  altimeterBackgroundColor = Color(64, 64, 64);
+  altimeterBaselineRatio = 0.75;
+  altimeterNumberGap = 7;
+
+  statusRegionMargin = 5;
+  adjustingRegionMargin = 10;
+
+  baroLeftOffset =
+      width / 12;
+  baroFontSmall = Font(
+      fontName,
+      width / 20);
+  baroTextColor = Color(255, 255, 255);
+
+  const double alphaRange = settings->alpha_max() - settings->alpha_min();
+  const double knotsOrMph =
+      settings->speed_units() == "knots" ? meters_per_second_to_knots(1) :
+      settings->speed_units() == "mph" ? meters_per_second_to_mph(1) :
+      0;
+  ballTransform = {
+      .xPerBeta = (float) (displayRegionHalfWidth * radians_to_degrees(1) / settings->beta_full_scale()),
+      .x0 = (float) (displayRegionHalfWidth * (1 + settings->beta_bias() / settings->beta_full_scale())),
+      .yPerAlpha = (float) (airballHeight * radians_to_degrees(1) / alphaRange),
+      .y0 = (float) (-airballHeight * settings->alpha_min() / alphaRange),
+      .radiusPerIas = (float) (knotsOrMph / settings->ias_full_scale() * width / 2),
+  };
+
+  unitsAnnotation = settings->speed_units();
+  if (settings->show_altimeter()) {
+    unitsAnnotation += " ft fpm inHg";
+  }
+
+  adjustmentName = settings->adjustmentDisplayName();
+  adjustmentValue = settings->adjustmentDisplayValue();
+
+  char buf[32];
+  baroSettingText.assign(buf, std::to_chars(
+      buf, buf + sizeof(buf), settings->baro_setting(), std::chars_format::fixed, 2).ptr);
+}
+
+// The display positions of a history of balls.
+struct BallPositions {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> radius;
+};
+
+// Writes as much of the text as fits into [first, last), and returns the end
+// of what was written.
+static char* writeText(char* first, char* last, const char* text) {
+  while (first < last && *text != '\0') {
+    *first++ = *text++;
+  }
+  return first;
+}
+
+// Writes the number with the given digits after the point, or nothing if it
+// does not fit.
+static char* writeNumber(char* first, char* last, double value, int precision) {
+  auto result = std::to_chars(first, last, value, std::chars_format::fixed, precision);
+  return result.ec == std::errc() ? result.ptr : first;
+}
+
+static char* writeNumber(char* first, char* last, unsigned long value) {
+  auto result = std::to_chars(first, last, value);
+  return result.ec == std::errc() ? result.ptr : first;
+}
+
+static void placeBalls(
+    const IAirdata::BallHistory& balls,
+    const Layout::BallTransform& t,
+    BallPositions* positions) {
+  const size_t n = balls.size();
+  positions->x.resize(n);
+  positions->y.resize(n);
+  positions->radius.resize(n);
+  const float* __restrict alpha = balls.alpha();
+  const float* __restrict beta = balls.beta();
+  const float* __restrict ias = balls.ias();
+  float* __restrict x = positions->x.data();
+  float* __restrict y = positions->y.data();
+  float* __restrict radius = positions->radius.data();
+  for (size_t i = 0; i < n; i++) {
+    x[i] = t.xPerBeta * beta[i] + t.x0;
+    y[i] = t.yPerAlpha * alpha[i] + t.y0;
+    radius[i] = t.radiusPerIas * ias[i];
+  }
+}
+
+// Memory allowed for pre-rendered airspeed limit sprites.
+constexpr size_t kAirballSpriteCacheBytes = 2 * 1024 * 1024;
+
+// Room left around the contents of each sprite for anti-aliasing.
+constexpr int kSpriteMargin = 2;
+
+// The raw airballs drawn at the SHORT_TRAIL quality and below.
+constexpr size_t kShortTrailLength = 5;
+
+class ViewState {
+public:
+  explicit ViewState(const AirballView::Options& options)
+      : options(options),
+        regionWorkers(options.parallelRegions ? std::make_unique<ThreadPool>(1) : nullptr) {}
+
+  const AirballView::Options options;
+  // The layout for the settings generation layoutGeneration.
+  std::unique_ptr<Layout> layout;
+  unsigned long layoutGeneration = 0;
+  // Everything beneath the airballs that does not depend on the airdata: the
+  // background and the VSI scale.
+  CachedLayer underlay;
+  // Everything painted over the airballs that does not depend on the airdata:
+  // the totem pole and the cow catcher.
+  CachedLayer overlay;
+  // Glyphs for the numeric readouts, in the fonts and colors of the layout.
+  std::unique_ptr<GlyphAtlas> iasGlyphs;
+  std::unique_ptr<GlyphAtlas> altimeterGlyphsLarge;
+  std::unique_ptr<GlyphAtlas> altimeterGlyphsSmall;
+  std::unique_ptr<GlyphAtlas> baroGlyphs;
+  // The airspeed limits drawn around the smooth airball.
+  SpriteCache airballSprites{kAirballSpriteCacheBytes};
+  // The VSI strip, drawn by regionWorkers while the airball area is drawn
+  // into the screen, then copied into the screen.
+  CachedLayer vsiRegion;
+  std::unique_ptr<ThreadPool> regionWorkers;
+  // The frame drawn upright for a rotated display.
+  UprightFrame upright;
+  // The primitives of the overlay, recorded afresh each time it is drawn.
+  DisplayList overlayList;
+  // The primitives of the airspeed limits, recorded afresh each time they
+  // are drawn.
+  DisplayList limitsList;
+  // The primitives of the VSI scale and pointer, recorded afresh each time
+  // they are drawn: one list for the screen, and one for regionWorkers.
+  DisplayList vsiList;
+  DisplayList vsiRegionList;
+  // The raw airballs, if drawn as a phosphor trail.
+  PhosphorTrail rawTrail;
+  // Where the raw airballs of the current frame are drawn.
+  BallPositions rawPositions;
+  // Whether the overlay layer was drawn decluttered.
+  bool overlayDecluttered = false;
+  // The numeric readouts that depend on the airdata, as last drawn.
+  CachedText<long> iasText;
+  CachedText<int> altitudeThousandsText;
+  CachedText<int> altitudeHundredsText;
+  // The width of the wider of the adjustment's name and value, in the
+  // layout's font.
+  double adjustingTextWidth = 0;
+  // The lines of the performance HUD, for the last FrameStats summary.
+  CachedText<unsigned long> perfHudRates;
+  CachedText<unsigned long> perfHudTimes;
+  CachedText<unsigned long> perfHudCounts;
+  CachedText<unsigned long> perfHudTransfer;
+};
+
+class PaintCycle {
+public:
+  PaintCycle(const IAirballModel &model, IScreen *screen, ViewState &state)
+      : model_(model),
+        screen_(screen),
+        state_(state),
+        layout_(*state.layout),
+        quality_(state.options.governor == nullptr
+                 ? AirballView::FULL
+                 : std::min(state.options.governor->tier(), (int) AirballView::LOWEST_QUALITY)),
+        smoothBall_(model.airdata()->smooth_ball_at(std::chrono::steady_clock::now())),
+        vsiList_(state.vsiList),
+        cr_(screen->cr()) {}
+
+  // A cycle painting the same frame as another, into a different context,
+  // recording the VSI into a different list so that both may run at once.
+  PaintCycle(const PaintCycle& other, cairo_t* cr, DisplayList& vsiList)
+      : model_(other.model_),
+        screen_(other.screen_),
+        state_(other.state_),
+        layout_(other.layout_),
+        quality_(other.quality_),
+        smoothBall_(other.smoothBall_),
+        vsiList_(vsiList),
+        cr_(cr) {}
+
+  void paint();
+
+private:
+  struct VsiFrame {
+    Point top_left;
+    Point top_right;
+    Point center_left;
+    Point center_right;
+    Point bottom_left;
+    Point bottom_right;
+    double radians_per_fpm;
+  };
+
+  bool drawUpright();
+  // Whether the settings or the quality call for a decluttered display.
+  bool declutter();
+  void paintStaticLayers();
+  // The contents of the underlay and overlay layers.
+  void paintUnderlay();
+  void paintOverlay();
+  void paintBackground();
+  void paintRawAirballs();
+  void paintRawAirball(
+      const Point& center,
+      const double radius,
+      const double bright);
+  void paintSmoothAirball();
+  void paintAirballLowAirspeed(const Point& center);
+  void paintAirballAirspeed(
+      const Point& center,
+      const double radius,
+      const std::string& airspeedText);
+  void paintAirballAirspeedLimits(const Point& center, const bool rotate);
+  void paintAirballAirspeedLimitsNormal(DisplayList& list, const Point& center);
+  void paintAirballAirspeedLimitsRotate(DisplayList& list, const Point& center);
+  void paintAirballTrueAirspeed(
+      const Point& center,
+      const double tasRadius,
+      const double alpha);
+  double trueAirspeedAlpha();
+  double airspeedLimitsExtent(const bool rotate);
+  void paintTotemPole(DisplayList& list);
+  void paintTotemPoleLine(DisplayList& list);
+  void paintTotemPoleAlphaX(DisplayList& list);
+  void paintTotemPoleAlphaY(DisplayList& list);
+  void paintCowCatcher(DisplayList& list);
+  VsiFrame vsiFrame();
+  void clipVsi();
+  bool vsiInParallel();
+  void beginVsiRegion();
+  void endVsiRegion();
+  void paintVsiRegion();
+  void paintVsiBackground();
+  void paintVsi();
+  void paintVsiTicMarks(
+      DisplayList& list,
+      Point top_left,
+      Point top_right,
+      Point center_left,
+      Point center_right,
+      Point bottom_left,
+      Point bottom_right,
+      double radians_per_fpm);
+  void paintVsiPointer(
+      DisplayList& list,
+      Point top_left,
+      Point top_right,
+      Point center_left,
+      Point center_right,
+      Point bottom_left,
+      Point bottom_right,
+      double radians_per_fpm);
+  void paintAltitude(
+      Point top_left,
+      Point top_right,
+      Point center_left,
+      Point center_right,
+      Point bottom_left,
+      Point bottom_right);
+  void paintBaroSetting(
+      Point top_left,
+      Point top_right,
+      Point center_left,
+      Point center_right,
+      Point bottom_left,
+      Point bottom_right);
+  void paintNoFlightData();
+  void paintUnitsAnnotation();
+  void paintPerfHud();
+  void paintAdjusting();
+
+  double alpha_to_y(const double alpha);
+  double beta_to_x(const double beta);
+
+  double alpha_degrees_to_y(const double alpha_degrees);
+  double beta_degrees_to_x(const double beta_degrees);
+
+  double airspeed_to_display_units(const double airspeed);
+  double airspeed_to_radius(const double airspeed);
+  double airspeed_display_units_to_radius(const double airspeed_display_units);
+
+  const IAirballModel &model_;
+  IScreen *screen_;
+  ViewState &state_;
+  const Layout &layout_;
+  // The AirballView::Quality at which this frame is drawn.
+  const int quality_;
+  // The smooth ball as of the time this frame is drawn.
+  const IAirdata::Ball smoothBall_;
+  // Where the VSI is recorded, which no other thread uses during this frame.
+  DisplayList& vsiList_;
+
+  // The context currently being drawn into, which is either the screen or
+  // one of the static layers.
+  cairo_t *cr_;
+};
+
+AirballView::AirballView()
+    : AirballView(Options()) {}
+
+AirballView::AirballView(const Options& options)
+    : state_(std::make_unique<ViewState>(options)) {}
+
+AirballView::~AirballView() = default;
+
+int AirballView::spriteHits() const {
+  return state_->airballSprites.hits();
+}
+
+int AirballView::spriteMisses() const {
+  return state_->airballSprites.misses();
+}
+
+void AirballView::paint(const IAirballModel &m, IScreen *screen) {
+  if (state_->layout == nullptr ||
+      state_->layoutGeneration != m.settings()->generation()) {
+    state_->layout = std::make_unique<Layout>(m.settings());
+    state_->layoutGeneration = m.settings()->generation();
+    state_->underlay.invalidate();
+    state_->overlay.invalidate();
+    state_->airballSprites.clear();
+    state_->rawTrail.reset();
+    const Layout& layout = *state_->layout;
+    // An atlas with no glyphs draws all its text with the Cairo text API.
+    const std::string alphabet =
+        state_->options.glyphAtlas ? GlyphAtlas::kNumericAlphabet : "";
+    state_->iasGlyphs = std::make_unique<GlyphAtlas>(
+        layout.iASTextFont, layout.iASTextColor, alphabet);
+    state_->altimeterGlyphsLarge = std::make_unique<GlyphAtlas>(
+        layout.altimeterFontLarge, layout.altimeterTextColor, alphabet);
+    state_->altimeterGlyphsSmall = std::make_unique<GlyphAtlas>(
+        layout.altimeterFontSmall, layout.altimeterTextColor, alphabet);
+    state_->baroGlyphs = std::make_unique<GlyphAtlas>(
+        layout.baroFontSmall, layout.baroTextColor, alphabet);
+    // Load the fonts now, rather than partway through drawing the frame.
+    for (const Font* font : {
+             &layout.iASTextFont,
+             &layout.statusTextFont,
+             &layout.adjustingTextFont,
+             &layout.altimeterFontLarge,
+             &layout.altimeterFontSmall,
+             &layout.baroFontSmall}) {
+      font->warm(screen->cr());
+    }
+    state_->adjustingTextWidth = std::max(
+        text_size(screen->cr(), layout.adjustmentName, layout.adjustingTextFont).w(),
+        text_size(screen->cr(), layout.adjustmentValue, layout.adjustingTextFont).w());
+  }
+  PaintCycle(m, screen, *state_).paint();
 }
 
 double PaintCycle::alpha_to_y(const double alpha) {
@@ -348,7 +644,7 @@ double PaintCycle::alpha_to_y(const double alpha) {
 double PaintCycle::alpha_degrees_to_y(const double alpha_degrees) {
   double ratio = (alpha_degrees - model_.settings()->alpha_min())
                  / (model_.settings()->alpha_max() - model_.settings()->alpha_min());
-  return ratio * airballHeight_;
+  return ratio * layout_.airballHeight;
 }
 
 double PaintCycle::beta_to_x(const double beta) {
@@ -357,7 +653,7 @@ double PaintCycle::beta_to_x(const double beta) {
 
 double PaintCycle::beta_degrees_to_x(const double beta_degrees) {
   double ratio = (beta_degrees + model_.settings()->beta_bias()) / model_.settings()->beta_full_scale();
-  return displayRegionHalfWidth_ * (1.0 + ratio);
+  return layout_.displayRegionHalfWidth * (1.0 + ratio);
 }
 
 double PaintCycle::airspeed_to_display_units(const double airspeed) {
@@ -376,77 +672,215 @@ double PaintCycle::airspeed_to_radius(const double airspeed) {
 
 double PaintCycle::airspeed_display_units_to_radius(const double airspeed_display_units) {
   double ratio = airspeed_display_units / model_.settings()->ias_full_scale();
-  return ratio * width_ / 2;
+  return ratio * layout_.width / 2;
 }
 
 void PaintCycle::paint() {
-  layout();
-
   screen_->setBrightness(model_.settings()->screen_brightness());
 
-  // cairo_push_group(screen_->cr());
+  // cairo_push_group(cr_);
 
-  if (model_.settings()->rotate_screen()) {
-    cairo_translate(screen_->cr(), 0, width_);
-    cairo_rotate(screen_->cr(), -M_PI / 2);
+  cairo_t *screen_cr = cr_;
+  const bool upright = drawUpright();
+  if (upright) {
+    cr_ = state_.upright.begin(screen_->cs(), (int) layout_.width, (int) layout_.height);
   }
 
-  cairo_save(screen_->cr());
+  // The screen's context persists from one frame to the next, so the
+  // rotation must not be left applied to it.
+  cairo_save(cr_);
 
-  paintBackground();
+  if (model_.settings()->rotate_screen() && !upright) {
+    cairo_translate(cr_, 0, layout_.width);
+    cairo_rotate(cr_, -M_PI / 2);
+  }
+
+  if (quality_ >= AirballView::FAST_ANTIALIAS) {
+    cairo_set_antialias(cr_, CAIRO_ANTIALIAS_FAST);
+  }
+
+  if (state_.overlayDecluttered != declutter()) {
+    state_.overlay.invalidate();
+    state_.overlayDecluttered = declutter();
+  }
+
+  paintStaticLayers();
+
+  const bool vsiParallel = vsiInParallel();
+  if (vsiParallel) {
+    beginVsiRegion();
+  }
+
+  cairo_save(cr_);
+
+  {
+    AIRBALL_TIME_STAGE("background");
+    if (state_.options.cacheLayers) {
+      state_.underlay.paint(cr_);
+    } else {
+      paintUnderlay();
+    }
+  }
 
-  cairo_rectangle(screen_->cr(), 0, 0, width_, airballHeight_);
-  cairo_clip(screen_->cr());
+  cairo_rectangle(cr_, 0, 0, layout_.width, layout_.airballHeight);
+  cairo_clip(cr_);
 
   if (model_.airdata()->valid()) {
-    paintRawAirballs();
-    paintSmoothAirball();
+    {
+      AIRBALL_TIME_STAGE("raw_airballs");
+      paintRawAirballs();
+    }
+    {
+      AIRBALL_TIME_STAGE("smooth_airball");
+      paintSmoothAirball();
+    }
   }
 
-  paintTotemPole();
-  paintCowCatcher();
-  paintUnitsAnnotation();
-  paintAdjusting();
+  {
+    AIRBALL_TIME_STAGE("overlay");
+    if (state_.options.cacheLayers) {
+      state_.overlay.paint(cr_);
+    } else {
+      paintOverlay();
+    }
+  }
+  {
+    AIRBALL_TIME_STAGE("adjusting");
+    paintUnitsAnnotation();
+    paintAdjusting();
+  }
+  if (model_.settings()->show_perf_hud() && state_.options.frameStats != nullptr) {
+    AIRBALL_TIME_STAGE("perf_hud");
+    paintPerfHud();
+  }
 
-  cairo_restore(screen_->cr());
+  cairo_restore(cr_);
 
-  if (model_.settings()->show_altimeter()) {
-    cairo_save(screen_->cr());
-    cairo_rectangle(screen_->cr(), 0, airballHeight_ + displayMargin_, width_, vsiHeight_);
-    cairo_clip(screen_->cr());
+  if (vsiParallel) {
+    endVsiRegion();
+  } else if (model_.settings()->show_altimeter()) {
+    AIRBALL_TIME_STAGE("vsi");
+    cairo_save(cr_);
+    clipVsi();
     paintVsi();
-    cairo_restore(screen_->cr());
+    cairo_restore(cr_);
   }
 
   if (!model_.airdata()->valid()) {
+    AIRBALL_TIME_STAGE("no_flight_data");
     paintNoFlightData();
   }
   
-  // cairo_restore(screen_->cr());
+  // cairo_restore(cr_);
+
+  cairo_restore(cr_);
+
+  if (upright) {
+    AIRBALL_TIME_STAGE("rotate");
+    state_.upright.end(screen_->cs());
+    cr_ = screen_cr;
+  }
 
+  AIRBALL_TIME_STAGE("surface_flush");
   cairo_surface_flush(screen_->cs());
-  screen_->flush();
+}
+
+bool PaintCycle::drawUpright() {
+  return
+      state_.options.uprightRotation &&
+      model_.settings()->rotate_screen() &&
+      UprightFrame::supports(screen_->cs(), (int) layout_.width, (int) layout_.height);
+}
+
+bool PaintCycle::declutter() {
+  return model_.settings()->declutter() || quality_ >= AirballView::DECLUTTER;
+}
+
+void PaintCycle::paintStaticLayers() {
+  if (!state_.options.cacheLayers ||
+      (state_.underlay.valid() && state_.overlay.valid())) {
+    return;
+  }
+  AIRBALL_TIME_STAGE("static_layers");
+
+  cairo_t *screen_cr = cr_;
+
+  cr_ = state_.underlay.begin(screen_->cs(), layout_.width, layout_.height, true);
+  paintUnderlay();
+  state_.underlay.end();
+
+  cr_ = state_.overlay.begin(screen_->cs(), layout_.width, layout_.airballHeight, false);
+  paintOverlay();
+  state_.overlay.end();
+
+  cr_ = screen_cr;
+}
+
+void PaintCycle::paintUnderlay() {
+  paintBackground();
+  if (model_.settings()->show_altimeter()) {
+    cairo_save(cr_);
+    clipVsi();
+    paintVsiBackground();
+    cairo_restore(cr_);
+  }
+}
+
+void PaintCycle::paintOverlay() {
+  DisplayList& list = state_.overlayList;
+  list.clear();
+  {
+    AIRBALL_TIME_STAGE("totem_pole");
+    paintTotemPole(list);
+  }
+  {
+    AIRBALL_TIME_STAGE("cow_catcher");
+    paintCowCatcher(list);
+  }
+  AIRBALL_TIME_STAGE("overlay_replay");
+  list.replay(cr_, state_.options.displayLists);
 }
 
 void PaintCycle::paintBackground() {
   rectangle(
-      screen_->cr(),
+      cr_,
       Point(0, 0),
-      Size(width_, height_),
-      background_);
+      Size(layout_.width, layout_.height),
+      layout_.background);
 }
 
 void PaintCycle::paintRawAirballs() {
-  for (uint i = model_.airdata()->raw_balls().size(); i-- > 0; ) {
-    uint bright_index = model_.airdata()->raw_balls().size() - i;
+  const IAirdata::BallHistory& balls = model_.airdata()->raw_balls();
+  const BallPositions& p = state_.rawPositions;
+  placeBalls(balls, layout_.ballTransform, &state_.rawPositions);
+  if (state_.options.phosphorTrail) {
+    state_.rawTrail.update(
+        screen_->cs(),
+        (int) layout_.width,
+        (int) layout_.airballHeight,
+        balls,
+        layout_.rawAirballsMaxBrightness,
+        [&p](cairo_t* cr, size_t i, double bright) {
+          disc(
+              cr,
+              Point(p.x[i], p.y[i]),
+              p.radius[i],
+              Color(0, 0, 0, bright));
+        });
+    state_.rawTrail.paint(cr_, layout_.airballFill);
+    return;
+  }
+  // The newest ball is first. A short trail fades out just as quickly as
+  // the full one, only sooner.
+  const size_t n = quality_ >= AirballView::SHORT_TRAIL
+      ? std::min(balls.size(), kShortTrailLength)
+      : balls.size();
+  for (size_t i = n; i-- > 0; ) {
+    size_t bright_index = n - i;
     double bright =
-        ((double) bright_index) / ((double) model_.airdata()->raw_balls().size()) *
-        rawAirballsMaxBrightness_;
-    Point center(
-        beta_to_x(model_.airdata()->raw_balls()[i].beta()),
-        alpha_to_y((model_.airdata()->raw_balls()[i].alpha())));
-    double radius = airspeed_to_radius(model_.airdata()->raw_balls()[i].ias());
-    paintRawAirball(center, radius, bright);
+        ((double) bright_index) / ((double) n) *
+        layout_.rawAirballsMaxBrightness;
+    paintRawAirball(Point(p.x[i], p.y[i]), p.radius[i], bright);
   }
 }
 
@@ -455,498 +889,621 @@ void PaintCycle::paintRawAirball(
     const double radius,
     const double bright) {
   disc(
-      screen_->cr(),
+      cr_,
       center,
       radius,
-      airballFill_.with_brightness(bright));
+      layout_.airballFill.with_brightness(bright));
 }
 
 void PaintCycle::paintSmoothAirball() {
-  Point center(beta_to_x(model_.airdata()->smooth_ball().beta()), alpha_to_y((model_.airdata()->smooth_ball().alpha())));
-  double radius = airspeed_to_radius(model_.airdata()->smooth_ball().ias());
-  if (radius < lowSpeedThresholdAirballRadius_) {
+  const IAirdata::Ball& ball = smoothBall_;
+  Point center(beta_to_x(ball.beta()), alpha_to_y((ball.alpha())));
+  double radius = airspeed_to_radius(ball.ias());
+  if (radius < layout_.lowSpeedThresholdAirballRadius) {
     paintAirballLowAirspeed(center);
+    return;
+  }
+
+  std::string iasText;
+  if (model_.settings()->show_numeric_airspeed()) {
+    iasText = state_.iasText.get(
+        lrint(airspeed_to_display_units(ball.ias())),
+        [](char* first, char* last, long ias) {
+          return std::to_chars(first, last, ias).ptr;
+        });
+  }
+  const bool rotate =
+      airspeed_to_display_units(ball.ias()) < model_.settings()->v_r();
+
+  // The airball, its airspeed and the TAS rosette change with nearly every
+  // sample, so they are drawn as they are.
+  paintAirballAirspeed(center, radius, iasText);
+  paintAirballTrueAirspeed(center, airspeed_to_radius(ball.tas()), trueAirspeedAlpha());
+
+  if (!state_.options.spriteCache) {
+    paintAirballAirspeedLimits(center, rotate);
+    return;
+  }
+
+  // The airspeed limits are drawn at radii fixed by the settings, so only
+  // their shape, the sub-pixel position and the quality tell sprites apart.
+  SpriteCache::Key key;
+  key.limits = rotate ? 1 : 0;
+  key.antialias = quality_ >= AirballView::FAST_ANTIALIAS ? 1 : 0;
+  state_.airballSprites.paint(
+      cr_,
+      key,
+      center,
+      (int) ceil(airspeedLimitsExtent(rotate)) + kSpriteMargin,
+      [&](cairo_t* cr, const Point& spriteCenter) {
+        cairo_t* screen_cr = cr_;
+        cr_ = cr;
+        if (key.antialias != 0) {
+          cairo_set_antialias(cr_, CAIRO_ANTIALIAS_FAST);
+        }
+        paintAirballAirspeedLimits(spriteCenter, rotate);
+        cr_ = screen_cr;
+      });
+}
+
+double PaintCycle::airspeedLimitsExtent(const bool rotate) {
+  double extent = 0;
+  if (rotate) {
+    if (model_.settings()->v_r() > 0) {
+      double r = airspeed_display_units_to_radius(model_.settings()->v_r());
+      extent = std::max(
+          extent,
+          hypot(r + layout_.totemPoleAlphaUnit, layout_.totemPoleAlphaUnit) +
+          layout_.airballCrosshairsStroke.width() / 2);
+    }
   } else {
-    paintAirballAirspeed(center, radius);
-    paintAirballTrueAirspeed(center);
-    paintAirballAirspeedLimits(center);
+    const std::pair<double, Stroke> limits[] = {
+        {model_.settings()->v_fe(), layout_.vfeStroke},
+        {model_.settings()->v_no(), layout_.vnoStroke},
+        {model_.settings()->v_ne(), layout_.vneStroke},
+    };
+    for (const auto& [v, stroke] : limits) {
+      if (v > 0) {
+        extent = std::max(
+            extent,
+            airspeed_display_units_to_radius(v) +
+            std::max(stroke.width(), layout_.vBackgroundStroke.width()) / 2);
+      }
+    }
   }
+  return extent;
 }
 
 void PaintCycle::paintAirballLowAirspeed(const Point& center) {
   arc(
-      screen_->cr(),
+      cr_,
       center,
-      lowSpeedAirballArcRadius_,
+      layout_.lowSpeedAirballArcRadius,
       0,
       2.0 * M_PI,
-      lowSpeedAirballStroke_);
+      layout_.lowSpeedAirballStroke);
 }
 
-void PaintCycle::paintAirballAirspeed(const Point& center, const double radius) {
+void PaintCycle::paintAirballAirspeed(
+    const Point& center,
+    const double radius,
+    const std::string& airspeedText) {
   disc(
-      screen_->cr(),
+      cr_,
       center,
       radius,
-      airballFill_);
+      layout_.airballFill);
   line(
-      screen_->cr(),
+      cr_,
       Point(center.x(), center.y() - radius),
       Point(center.x(), center.y() + radius),
-      airballCrosshairsStroke_);
+      layout_.airballCrosshairsStroke);
   line(
-      screen_->cr(),
+      cr_,
       Point(center.x() - radius, center.y()),
       Point(center.x() + radius, center.y()),
-      airballCrosshairsStroke_);
+      layout_.airballCrosshairsStroke);
 
-  if (model_.settings()->show_numeric_airspeed()) {
+  if (!airspeedText.empty()) {
     // Determine the size of the airspeed text
-    char airspeedText[printBufSize_];
-    double ias_display_units_ =
-        airspeed_to_display_units(model_.airdata()->smooth_ball().ias());
-    snprintf(
-        airspeedText,
-        printBufSize_,
-        "%.0f",
-        ias_display_units_);
     Size airspeedTextSize =
-        text_size(screen_->cr(), airspeedText, iASTextFont_);
+        state_.iasGlyphs->text_size(cr_, airspeedText);
     Size airspeedBoundingBoxSize(
-        airspeedTextSize.w() + 2 * iASTextMargin_,
-        airspeedTextSize.h() + 2 * iASTextMargin_);
+        airspeedTextSize.w() + 2 * layout_.iASTextMargin,
+        airspeedTextSize.h() + 2 * layout_.iASTextMargin);
 
     double airspeedTickMarkLength = 4; // IHAB todo
     double airspeedTickMarkStrokeWidth = 3; // IHAB todo
 
     line(
-        screen_->cr(),
+        cr_,
         Point(center.x() - (airspeedBoundingBoxSize.w() / 2 + airspeedTickMarkLength), center.y()),
         Point(center.x() + (airspeedBoundingBoxSize.w() / 2 + airspeedTickMarkLength), center.y()),
-        Stroke(airballFill_, airspeedTickMarkStrokeWidth)); // IHAB todo
+        Stroke(layout_.airballFill, airspeedTickMarkStrokeWidth)); // IHAB todo
 
     line(
-        screen_->cr(),
+        cr_,
         Point(center.x(), center.y() - (airspeedBoundingBoxSize.h() / 2 + airspeedTickMarkLength)),
         Point(center.x(), center.y() + (airspeedBoundingBoxSize.h() / 2 + airspeedTickMarkLength)),
-        Stroke(airballFill_, airspeedTickMarkStrokeWidth)); // IHAB todo
+        Stroke(layout_.airballFill, airspeedTickMarkStrokeWidth)); // IHAB todo
 
     round_rectangle(
-        screen_->cr(),
+        cr_,
         Point(
             center.x() - airspeedBoundingBoxSize.w() / 2,
             center.y() - airspeedBoundingBoxSize.h() / 2),
         airspeedBoundingBoxSize,
-        iASTextMargin_,
-        airballFill_); // IHAB todo
+        layout_.iASTextMargin,
+        layout_.airballFill); // IHAB todo
 
-    draw_text(
-        screen_->cr(),
+    state_.iasGlyphs->draw_text(
+        cr_,
         airspeedText,
         center,
-        TextReferencePoint::CENTER_MID_UPPERCASE,
-        iASTextFont_,
-        iASTextColor_);
+        TextReferencePoint::CENTER_MID_UPPERCASE);
   }
 }
 
-void PaintCycle::paintAirballAirspeedLimits(const Point& center) {
-  if (airspeed_to_display_units(model_.airdata()->smooth_ball().ias()) < model_.settings()->v_r()) {
-    paintAirballAirspeedLimitsRotate(center);
+void PaintCycle::paintAirballAirspeedLimits(const Point& center, const bool rotate) {
+  DisplayList& list = state_.limitsList;
+  list.clear();
+  if (rotate) {
+    paintAirballAirspeedLimitsRotate(list, center);
   } else {
-    paintAirballAirspeedLimitsNormal(center);
+    paintAirballAirspeedLimitsNormal(list, center);
   }
+  list.replay(cr_, state_.options.displayLists);
 }
 
-void PaintCycle::paintAirballAirspeedLimitsRotate(const Point& center) {
+void PaintCycle::paintAirballAirspeedLimitsRotate(DisplayList& list, const Point& center) {
   if (model_.settings()->v_r() == 0) {
     return;
   }
   double r = airspeed_display_units_to_radius(model_.settings()->v_r());
-  line(
-      screen_->cr(),
+  list.line(
       Point(
           center.x() - r,
           center.y()),
       Point(
-          center.x() - r - totemPoleAlphaUnit_,
-          center.y() + totemPoleAlphaUnit_),
-      airballCrosshairsStroke_);
-  line(
-      screen_->cr(),
+          center.x() - r - layout_.totemPoleAlphaUnit,
+          center.y() + layout_.totemPoleAlphaUnit),
+      layout_.airballCrosshairsStroke);
+  list.line(
       Point(
           center.x() - r,
           center.y()),
       Point(
-          center.x() - r - totemPoleAlphaUnit_,
-          center.y() - totemPoleAlphaUnit_),
-      airballCrosshairsStroke_);
-  line(
-      screen_->cr(),
+          center.x() - r - layout_.totemPoleAlphaUnit,
+          center.y() - layout_.totemPoleAlphaUnit),
+      layout_.airballCrosshairsStroke);
+  list.line(
       Point(
           center.x() + r,
           center.y()),
       Point(
-          center.x() + r + totemPoleAlphaUnit_,
-          center.y() + totemPoleAlphaUnit_),
-      airballCrosshairsStroke_);
-  line(
-      screen_->cr(),
+          center.x() + r + layout_.totemPoleAlphaUnit,
+          center.y() + layout_.totemPoleAlphaUnit),
+      layout_.airballCrosshairsStroke);
+  list.line(
       Point(
           center.x() + r,
           center.y()),
       Point(
-          center.x() + r + totemPoleAlphaUnit_,
-          center.y() - totemPoleAlphaUnit_),
-      airballCrosshairsStroke_);
-  line(
-      screen_->cr(),
+          center.x() + r + layout_.totemPoleAlphaUnit,
+          center.y() - layout_.totemPoleAlphaUnit),
+      layout_.airballCrosshairsStroke);
+  list.line(
       Point(
           center.x(),
           center.y() + r),
       Point(
-          center.x() + totemPoleAlphaUnit_,
-          center.y() + r + totemPoleAlphaUnit_),
-      airballCrosshairsStroke_);
-  line(
-      screen_->cr(),
+          center.x() + layout_.totemPoleAlphaUnit,
+          center.y() + r + layout_.totemPoleAlphaUnit),
+      layout_.airballCrosshairsStroke);
+  list.line(
       Point(
           center.x(),
           center.y() + r),
       Point(
-          center.x() - totemPoleAlphaUnit_,
-          center.y() + r + totemPoleAlphaUnit_),
-      airballCrosshairsStroke_);
-  line(
-      screen_->cr(),
+          center.x() - layout_.totemPoleAlphaUnit,
+          center.y() + r + layout_.totemPoleAlphaUnit),
+      layout_.airballCrosshairsStroke);
+  list.line(
       Point(
           center.x(),
           center.y() - r),
       Point(
-          center.x() + totemPoleAlphaUnit_,
-          center.y() - r - totemPoleAlphaUnit_),
-      airballCrosshairsStroke_);
-  line(
-      screen_->cr(),
+          center.x() + layout_.totemPoleAlphaUnit,
+          center.y() - r - layout_.totemPoleAlphaUnit),
+      layout_.airballCrosshairsStroke);
+  list.line(
       Point(
           center.x(),
           center.y() - r),
       Point(
-          center.x() - totemPoleAlphaUnit_,
-          center.y() - r - totemPoleAlphaUnit_),
-      airballCrosshairsStroke_);
+          center.x() - layout_.totemPoleAlphaUnit,
+          center.y() - r - layout_.totemPoleAlphaUnit),
+      layout_.airballCrosshairsStroke);
 }
 
-void PaintCycle::paintAirballAirspeedLimitsNormal(const Point& center) {
+void PaintCycle::paintAirballAirspeedLimitsNormal(DisplayList& list, const Point& center) {
   if (model_.settings()->v_fe() > 0) {
-    rosette(
-        screen_->cr(),
+    list.rosette(
         center,
         airspeed_display_units_to_radius(model_.settings()->v_fe()),
         4,
-        speedLimitsRosetteHalfAngle_,
+        layout_.speedLimitsRosetteHalfAngle,
         M_PI_4,
-        vBackgroundStroke_);
-    rosette(
-        screen_->cr(),
+        layout_.vBackgroundStroke);
+    list.rosette(
         center,
         airspeed_display_units_to_radius(model_.settings()->v_fe()),
         4,
-        speedLimitsRosetteHalfAngle_,
+        layout_.speedLimitsRosetteHalfAngle,
         M_PI_4,
-        vfeStroke_);
+        layout_.vfeStroke);
   }
   if (model_.settings()->v_no() > 0) {
-    rosette(
-        screen_->cr(),
+    list.rosette(
         center,
         airspeed_display_units_to_radius(model_.settings()->v_no()),
         4,
-        speedLimitsRosetteHalfAngle_,
+        layout_.speedLimitsRosetteHalfAngle,
         M_PI_4,
-        vBackgroundStroke_);
-    rosette(
-        screen_->cr(),
+        layout_.vBackgroundStroke);
+    list.rosette(
         center,
         airspeed_display_units_to_radius(model_.settings()->v_no()),
         4,
-        speedLimitsRosetteHalfAngle_,
+        layout_.speedLimitsRosetteHalfAngle,
         M_PI_4,
-        vnoStroke_);
+        layout_.vnoStroke);
   }
   if (model_.settings()->v_ne() > 0) {
-    rosette(
-        screen_->cr(),
+    list.rosette(
         center,
         airspeed_display_units_to_radius(model_.settings()->v_ne()),
         4,
-        speedLimitsRosetteHalfAngle_,
+        layout_.speedLimitsRosetteHalfAngle,
         M_PI_4,
-        vBackgroundStroke_);
-    rosette(
-        screen_->cr(),
+        layout_.vBackgroundStroke);
+    list.rosette(
         center,
         airspeed_display_units_to_radius(model_.settings()->v_ne()),
         4,
-        speedLimitsRosetteHalfAngle_,
+        layout_.speedLimitsRosetteHalfAngle,
         M_PI_4,
-        vneStroke_);
+        layout_.vneStroke);
   }
 }
 
-void PaintCycle::paintAirballTrueAirspeed(const Point& center) {
+double PaintCycle::trueAirspeedAlpha() {
+  if (quality_ >= AirballView::NO_TAS_ROSETTE) {
+    return 0;
+  }
   double tas_stroe_alpha_ = 0;
-  if (model_.airdata()->smooth_ball().tas() <
-      model_.airdata()->smooth_ball().ias() || model_.airdata()->smooth_ball().ias() == 0) {
+  if (smoothBall_.tas() <
+      smoothBall_.ias() || smoothBall_.ias() == 0) {
     tas_stroe_alpha_ = 0;
   } else {
     double ias_squared =
-        model_.airdata()->smooth_ball().ias() * model_.airdata()->smooth_ball().ias();
+        smoothBall_.ias() * smoothBall_.ias();
     double tas_squared =
-        model_.airdata()->smooth_ball().tas() * model_.airdata()->smooth_ball().tas();
+        smoothBall_.tas() * smoothBall_.tas();
     double ratio = (tas_squared - ias_squared) / ias_squared;
-    tas_stroe_alpha_ = (ratio > tasThresholdRatio_)
-                       ? 1.0 : (ratio / tasThresholdRatio_);
+    tas_stroe_alpha_ = (ratio > layout_.tasThresholdRatio)
+                       ? 1.0 : (ratio / layout_.tasThresholdRatio);
+  }
+  return tas_stroe_alpha_;
+}
+
+void PaintCycle::paintAirballTrueAirspeed(
+    const Point& center,
+    const double tasRadius,
+    const double alpha) {
+  if (alpha <= 0) {
+    return;
   }
   rosette(
-      screen_->cr(),
+      cr_,
       center,
-      airspeed_to_radius(model_.airdata()->smooth_ball().tas()),
+      tasRadius,
       4,
-      trueAirspeedRosetteHalfAngle_,
+      layout_.trueAirspeedRosetteHalfAngle,
       0,
       Stroke(
-          tasRingColor_.with_alpha(tas_stroe_alpha_),
-          tasRingStrokeWidth_));
+          layout_.tasRingColor.with_alpha(alpha),
+          layout_.tasRingStrokeWidth));
 }
 
-void PaintCycle::paintTotemPole() {
-  paintTotemPoleLine();
-  paintTotemPoleAlphaX();
-  paintTotemPoleAlphaY();
+void PaintCycle::paintTotemPole(DisplayList& list) {
+  paintTotemPoleLine(list);
+  paintTotemPoleAlphaX(list);
+  paintTotemPoleAlphaY(list);
 }
 
-void PaintCycle::paintTotemPoleLine() {
-  if (model_.settings()->declutter()) {
-    line(
-        screen_->cr(),
-        Point(displayXMid_, 0),
-        Point(displayXMid_,airballHeight_),
-        totemPoleStroke_);
+void PaintCycle::paintTotemPoleLine(DisplayList& list) {
+  if (declutter()) {
+    list.line(
+        Point(layout_.displayXMid, 0),
+        Point(layout_.displayXMid,layout_.airballHeight),
+        layout_.totemPoleStroke);
   } else {
-    line(
-        screen_->cr(),
-        Point(displayXMid_, 0),
-        Point(displayXMid_,
-              alpha_degrees_to_y(model_.settings()->alpha_ref()) - alphaRefRadius_),
-        totemPoleStroke_);
-    line(
-        screen_->cr(),
-        Point(displayXMid_,
-              alpha_degrees_to_y(model_.settings()->alpha_ref()) + alphaRefRadius_),
-        Point(displayXMid_, airballHeight_),
-        totemPoleStroke_);
-    arc(
-        screen_->cr(),
-        Point(displayXMid_, alpha_degrees_to_y(model_.settings()->alpha_ref())),
-        alphaRefRadius_,
-        alphaRefTopAngle0_,
-        alphaRefTopAngle1_,
-        totemPoleStroke_);
-    arc(
-        screen_->cr(),
-        Point(displayXMid_, alpha_degrees_to_y(model_.settings()->alpha_ref())),
-        alphaRefRadius_,
-        alphaRefBotAngle0_,
-        alphaRefBotAngle1_,
-        totemPoleStroke_);
+    list.line(
+        Point(layout_.displayXMid, 0),
+        Point(layout_.displayXMid,
+              alpha_degrees_to_y(model_.settings()->alpha_ref()) - layout_.alphaRefRadius),
+        layout_.totemPoleStroke);
+    list.line(
+        Point(layout_.displayXMid,
+              alpha_degrees_to_y(model_.settings()->alpha_ref()) + layout_.alphaRefRadius),
+        Point(layout_.displayXMid, layout_.airballHeight),
+        layout_.totemPoleStroke);
+    list.arc(
+        Point(layout_.displayXMid, alpha_degrees_to_y(model_.settings()->alpha_ref())),
+        layout_.alphaRefRadius,
+        layout_.alphaRefTopAngle0,
+        layout_.alphaRefTopAngle1,
+        layout_.totemPoleStroke);
+    list.arc(
+        Point(layout_.displayXMid, alpha_degrees_to_y(model_.settings()->alpha_ref())),
+        layout_.alphaRefRadius,
+        layout_.alphaRefBotAngle0,
+        layout_.alphaRefBotAngle1,
+        layout_.totemPoleStroke);
   }
 }
 
-void PaintCycle::paintTotemPoleAlphaX() {
-  if (model_.settings()->declutter()) {
+void PaintCycle::paintTotemPoleAlphaX(DisplayList& list) {
+  if (declutter()) {
     return;
   }
-  line(
-      screen_->cr(),
+  list.line(
       Point(
-          displayXMid_ - 3 * totemPoleAlphaUnit_,
+          layout_.displayXMid - 3 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_x())),
       Point(
-          displayXMid_ - 2 * totemPoleAlphaUnit_,
+          layout_.displayXMid - 2 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_x())),
-      totemPoleStroke_);
-  line(
-      screen_->cr(),
+      layout_.totemPoleStroke);
+  list.line(
       Point(
-          displayXMid_ - 2 * totemPoleAlphaUnit_,
+          layout_.displayXMid - 2 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_x())),
       Point(
-          displayXMid_ - 3 * totemPoleAlphaUnit_,
-          alpha_degrees_to_y(model_.settings()->alpha_x()) - totemPoleAlphaUnit_) ,
-      totemPoleStroke_);
-  line(
-      screen_->cr(),
+          layout_.displayXMid - 3 * layout_.totemPoleAlphaUnit,
+          alpha_degrees_to_y(model_.settings()->alpha_x()) - layout_.totemPoleAlphaUnit) ,
+      layout_.totemPoleStroke);
+  list.line(
       Point(
-          displayXMid_ + 3 * totemPoleAlphaUnit_,
+          layout_.displayXMid + 3 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_x())),
       Point(
-          displayXMid_ + 2 * totemPoleAlphaUnit_,
+          layout_.displayXMid + 2 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_x())),
-      totemPoleStroke_);
-  line(
-      screen_->cr(),
+      layout_.totemPoleStroke);
+  list.line(
       Point(
-          displayXMid_ + 2 * totemPoleAlphaUnit_,
+          layout_.displayXMid + 2 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_x())),
       Point(
-          displayXMid_ + 3 * totemPoleAlphaUnit_,
-          alpha_degrees_to_y(model_.settings()->alpha_x()) - totemPoleAlphaUnit_) ,
-      totemPoleStroke_);
+          layout_.displayXMid + 3 * layout_.totemPoleAlphaUnit,
+          alpha_degrees_to_y(model_.settings()->alpha_x()) - layout_.totemPoleAlphaUnit) ,
+      layout_.totemPoleStroke);
 }
 
-void PaintCycle::paintTotemPoleAlphaY() {
-  if (model_.settings()->declutter()) {
+void PaintCycle::paintTotemPoleAlphaY(DisplayList& list) {
+  if (declutter()) {
     return;
   }
-  line(
-      screen_->cr(),
+  list.line(
       Point(
-          displayXMid_ - 4 * totemPoleAlphaUnit_,
+          layout_.displayXMid - 4 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_y())),
       Point(
-          displayXMid_ - 5 * totemPoleAlphaUnit_,
+          layout_.displayXMid - 5 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_y())),
-      totemPoleStroke_);
-  line(
-      screen_->cr(),
+      layout_.totemPoleStroke);
+  list.line(
       Point(
-          displayXMid_ - 5 * totemPoleAlphaUnit_,
+          layout_.displayXMid - 5 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_y())),
       Point(
-          displayXMid_ - 6 * totemPoleAlphaUnit_,
-          alpha_degrees_to_y(model_.settings()->alpha_y()) - totemPoleAlphaUnit_),
-      totemPoleStroke_);
-  line(
-      screen_->cr(),
+          layout_.displayXMid - 6 * layout_.totemPoleAlphaUnit,
+          alpha_degrees_to_y(model_.settings()->alpha_y()) - layout_.totemPoleAlphaUnit),
+      layout_.totemPoleStroke);
+  list.line(
       Point(
-          displayXMid_ + 4 * totemPoleAlphaUnit_,
+          layout_.displayXMid + 4 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_y())),
       Point(
-          displayXMid_ + 5 * totemPoleAlphaUnit_,
+          layout_.displayXMid + 5 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_y())),
-      totemPoleStroke_);
-  line(
-      screen_->cr(),
+      layout_.totemPoleStroke);
+  list.line(
       Point(
-          displayXMid_ + 5 * totemPoleAlphaUnit_,
+          layout_.displayXMid + 5 * layout_.totemPoleAlphaUnit,
           alpha_degrees_to_y(model_.settings()->alpha_y())),
       Point(
-          displayXMid_ + 6 * totemPoleAlphaUnit_,
-          alpha_degrees_to_y(model_.settings()->alpha_y()) - totemPoleAlphaUnit_),
-      totemPoleStroke_);
+          layout_.displayXMid + 6 * layout_.totemPoleAlphaUnit,
+          alpha_degrees_to_y(model_.settings()->alpha_y()) - layout_.totemPoleAlphaUnit),
+      layout_.totemPoleStroke);
 }
 
-void PaintCycle::paintCowCatcher() {
-  if (model_.settings()->declutter()) {
+void PaintCycle::paintCowCatcher(DisplayList& list) {
+  if (declutter()) {
     return;
   }
   double xStep =
-      (displayRegionWidth_ - (2 * displayMargin_)) /
-      (2 * numCowCatcherLines_);
+      (layout_.displayRegionWidth - (2 * layout_.displayMargin)) /
+      (2 * layout_.numCowCatcherLines);
   double yStall = alpha_degrees_to_y(model_.settings()->alpha_stall());
-  for (int i = 0; i < numCowCatcherLines_; i++) {
-    line(
-        screen_->cr(),
+  for (int i = 0; i < layout_.numCowCatcherLines; i++) {
+    list.line(
         Point(
-            displayXMid_ + i * xStep,
+            layout_.displayXMid + i * xStep,
             yStall),
         Point(
-            displayXMid_ + (i + 1) * xStep,
-            yStall + cowCatcherHeight_),
-        cowCatcherStroke_);
-    line(
-        screen_->cr(),
+            layout_.displayXMid + (i + 1) * xStep,
+            yStall + layout_.cowCatcherHeight),
+        layout_.cowCatcherStroke);
+    list.line(
         Point(
-            displayXMid_ - i * xStep,
+            layout_.displayXMid - i * xStep,
             yStall),
         Point(
-            displayXMid_ - (i + 1) * xStep,
-            yStall + cowCatcherHeight_),
-        cowCatcherStroke_);
+            layout_.displayXMid - (i + 1) * xStep,
+            yStall + layout_.cowCatcherHeight),
+        layout_.cowCatcherStroke);
   }
-  line(
-      screen_->cr(),
+  list.line(
       Point(
-          displayXMid_ - (numCowCatcherLines_ - 1) * xStep,
+          layout_.displayXMid - (layout_.numCowCatcherLines - 1) * xStep,
           yStall),
       Point(
-          displayXMid_ + (numCowCatcherLines_ - 1) * xStep,
+          layout_.displayXMid + (layout_.numCowCatcherLines - 1) * xStep,
           yStall),
-      cowCatcherStroke_);
+      layout_.cowCatcherStroke);
 }
 
-void PaintCycle::paintVsi() {
-  double radians_per_fpm =
-      atan(vsiHeight_ / 2 / width_) / vsiStepsFpm_[0].fpm;
+PaintCycle::VsiFrame PaintCycle::vsiFrame() {
   Point top_left(
       0,
-      airballHeight_ + displayMargin_);
+      layout_.airballHeight + layout_.displayMargin);
   Point top_right(
-      width_,
+      layout_.width,
       top_left.y());
   Point bottom_left(
       top_left.x(),
-      top_left.y() + vsiHeight_);
+      top_left.y() + layout_.vsiHeight);
   Point bottom_right(
       top_right.x(),
       bottom_left.y());
   Point center_left(
       top_left.x(),
-      top_left.y() + vsiHeight_ / 2);
+      top_left.y() + layout_.vsiHeight / 2);
   Point center_right(
       top_right.x(),
       center_left.y());
-  rectangle(
-      screen_->cr(),
-      top_left,
+  return {
+      .top_left = top_left,
+      .top_right = top_right,
+      .center_left = center_left,
+      .center_right = center_right,
+      .bottom_left = bottom_left,
+      .bottom_right = bottom_right,
+      .radians_per_fpm = layout_.vsiRadiansPerFpm,
+  };
+}
+
+void PaintCycle::clipVsi() {
+  cairo_rectangle(cr_, 0, layout_.airballHeight + layout_.displayMargin, layout_.width, layout_.vsiHeight);
+  cairo_clip(cr_);
+}
+
+bool PaintCycle::vsiInParallel() {
+  // Xlib may not be used from more than one thread, so only images in memory
+  // are drawn in parallel.
+  return
+      state_.regionWorkers != nullptr &&
+      model_.settings()->show_altimeter() &&
+      cairo_surface_get_type(screen_->cs()) == CAIRO_SURFACE_TYPE_IMAGE;
+}
+
+void PaintCycle::beginVsiRegion() {
+  cairo_t* cr = state_.vsiRegion.begin(
+      screen_->cs(), layout_.width, layout_.vsiHeight, true);
+  const double top = vsiFrame().top_left.y();
+  state_.regionWorkers->submit([this, cr, top]() {
+    cairo_save(cr);
+    // The region is drawn at the same quality as the rest of the frame.
+    if (quality_ >= AirballView::FAST_ANTIALIAS) {
+      cairo_set_antialias(cr, CAIRO_ANTIALIAS_FAST);
+    }
+    cairo_translate(cr, 0, -top);
+    PaintCycle(*this, cr, state_.vsiRegionList).paintVsiRegion();
+    cairo_restore(cr);
+  });
+}
+
+void PaintCycle::endVsiRegion() {
+  state_.regionWorkers->wait();
+  state_.vsiRegion.end();
+  cairo_save(cr_);
+  cairo_translate(cr_, 0, vsiFrame().top_left.y());
+  state_.vsiRegion.paint(cr_);
+  cairo_restore(cr_);
+}
+
+void PaintCycle::paintVsiRegion() {
+  AIRBALL_TIME_STAGE("vsi");
+  clipVsi();
+  // The region is opaque, so it starts with what lies beneath the VSI.
+  if (state_.options.cacheLayers) {
+    state_.underlay.paint(cr_);
+  } else {
+    paintUnderlay();
+  }
+  paintVsi();
+}
+
+void PaintCycle::paintVsiBackground() {
+  VsiFrame f = vsiFrame();
+  DisplayList& list = vsiList_;
+  list.clear();
+  list.rectangle(
+      f.top_left,
       Size(
-          width_,
-          vsiHeight_),
-      altimeterBackgroundColor_);
+          layout_.width,
+          layout_.vsiHeight),
+      layout_.altimeterBackgroundColor);
   paintVsiTicMarks(
-      top_left,
-      top_right,
-      center_left,
-      center_right,
-      bottom_left,
-      bottom_right,
-      radians_per_fpm);
+      list,
+      f.top_left,
+      f.top_right,
+      f.center_left,
+      f.center_right,
+      f.bottom_left,
+      f.bottom_right,
+      f.radians_per_fpm);
+  list.replay(cr_, state_.options.displayLists);
+}
+
+void PaintCycle::paintVsi() {
+  VsiFrame f = vsiFrame();
+  DisplayList& list = vsiList_;
+  list.clear();
   paintVsiPointer(
-      top_left,
-      top_right,
-      center_left,
-      center_right,
-      bottom_left,
-      bottom_right,
-      radians_per_fpm);
-  paintAltitude(
-      top_left,
-      top_right,
-      center_left,
-      center_right,
-      bottom_left,
-      bottom_right);
+      list,
+      f.top_left,
+      f.top_right,
+      f.center_left,
+      f.center_right,
+      f.bottom_left,
+      f.bottom_right,
+      f.radians_per_fpm);
+  list.replay(cr_, state_.options.displayLists);
+  {
+    AIRBALL_TIME_STAGE("altitude");
+    paintAltitude(
+        f.top_left,
+        f.top_right,
+        f.center_left,
+        f.center_right,
+        f.bottom_left,
+        f.bottom_right);
+  }
   paintBaroSetting(
-      top_left,
-      top_right,
-      center_left,
-      center_right,
-      bottom_left,
-      bottom_right);
+      f.top_left,
+      f.top_right,
+      f.center_left,
+      f.center_right,
+      f.bottom_left,
+      f.bottom_right);
 }
 
 void PaintCycle::paintVsiTicMarks(
+    DisplayList& list,
     Point top_left,
     Point top_right,
     Point center_left,
@@ -954,62 +1511,55 @@ void PaintCycle::paintVsiTicMarks(
     Point bottom_left,
     Point bottom_right,
     double radians_per_fpm) {
-  line(
-      screen_->cr(),
+  list.line(
       top_right,
       Point(
           top_right.x(),
-          top_right.y() + vsiTickLength_),
-      vsiTickStrokeThin_);
-  line(
-      screen_->cr(),
+          top_right.y() + layout_.vsiTickLength),
+      layout_.vsiTickStrokeThin);
+  list.line(
       top_right,
       Point(
-          top_right.x() - vsiTickLength_,
+          top_right.x() - layout_.vsiTickLength,
           top_right.y()),
-      vsiTickStrokeThin_);
-  line(
-      screen_->cr(),
+      layout_.vsiTickStrokeThin);
+  list.line(
       bottom_right,
       Point(
           bottom_right.x(),
-          bottom_right.y() - vsiTickLength_),
-      vsiTickStrokeThin_);
-  line(
-      screen_->cr(),
+          bottom_right.y() - layout_.vsiTickLength),
+      layout_.vsiTickStrokeThin);
+  list.line(
       bottom_right,
       Point(
-          bottom_right.x() - vsiTickLength_,
+          bottom_right.x() - layout_.vsiTickLength,
           bottom_right.y()),
-      vsiTickStrokeThin_);
-  line(
-      screen_->cr(),
+      layout_.vsiTickStrokeThin);
+  list.line(
       center_right,
       Point(
-          center_right.x() - vsiTickLength_,
+          center_right.x() - layout_.vsiTickLength,
           center_right.y()),
-      vsiTickStrokeThin_);
-  for (auto i = vsiStepsFpm_.begin(); i < vsiStepsFpm_.end(); ++i) {
+      layout_.vsiTickStrokeThin);
+  for (auto i = layout_.vsiStepsFpm.begin(); i < layout_.vsiStepsFpm.end(); ++i) {
     double step_x =
         (center_left.y() - top_left.y()) /
         tan(i->fpm * radians_per_fpm);
     Stroke stroke(
-        vsiTickStrokeThin_.color(),
-        vsiTickStrokeThin_.width() * i->thick);
-    line(
-        screen_->cr(),
+        layout_.vsiTickStrokeThin.color(),
+        layout_.vsiTickStrokeThin.width() * i->thick);
+    list.line(
         Point(
             step_x,
             top_left.y()),
         Point(
             step_x,
-            top_left.y() + vsiTickLength_),
+            top_left.y() + layout_.vsiTickLength),
         stroke);
-    line(
-        screen_->cr(),
+    list.line(
         Point(
             step_x,
-            bottom_left.y() - vsiTickLength_),
+            bottom_left.y() - layout_.vsiTickLength),
         Point(
             step_x,
             bottom_left.y()),
@@ -1018,6 +1568,7 @@ void PaintCycle::paintVsiTicMarks(
 }
 
 void PaintCycle::paintVsiPointer(
+    DisplayList& list,
     Point top_left,
     Point top_right,
     Point center_left,
@@ -1027,40 +1578,37 @@ void PaintCycle::paintVsiPointer(
     double radians_per_fpm) {
   double climb_rate =
       model_.airdata()->climb_rate() / kMetersPerFoot * kSecondsPerMinute;
-  climb_rate = fmin(climb_rate, vsiStepsFpm_.back().fpm);
-  climb_rate = fmax(climb_rate, -vsiStepsFpm_.back().fpm);
+  climb_rate = fmin(climb_rate, layout_.vsiStepsFpm.back().fpm);
+  climb_rate = fmax(climb_rate, -layout_.vsiStepsFpm.back().fpm);
   double angle = climb_rate * radians_per_fpm;
-  if (fabs(climb_rate) <= vsiStepsFpm_[0].fpm) {
-    line(
-        screen_->cr(),
+  if (fabs(climb_rate) <= layout_.vsiStepsFpm[0].fpm) {
+    list.line(
         center_left,
         Point(
             center_right.x(),
             center_left.y() - (center_right.x() - center_left.x()) * sin(angle)),
-        vsiPointerStroke_);
+        layout_.vsiPointerStroke);
   } else {
     double dx = (center_left.y() - top_left.y()) / tan(angle);
     Point nee_(
         center_left.x() + fabs(dx),
         dx < 0 ? bottom_left.y() : top_left.y());
-    line(
-        screen_->cr(),
+    list.line(
         center_left,
         nee_,
-        vsiPointerStroke_);
+        layout_.vsiPointerStroke);
     Point a(
         nee_.x(),
         dx < 0
-            ? nee_.y() - vsiKneeOffset_
-            : nee_.y() + vsiKneeOffset_);
+            ? nee_.y() - layout_.vsiKneeOffset
+            : nee_.y() + layout_.vsiKneeOffset);
     Point b(
         center_right.x(),
         a.y());
-    line(
-        screen_->cr(),
+    list.line(
         a,
         b,
-        vsiPointerStroke_);
+        layout_.vsiPointerStroke);
   }
 }
 
@@ -1076,58 +1624,43 @@ void PaintCycle::paintAltitude(
   int last_three_digits = (abs(altitude) - (thousands * 1000)) / 10 * 10;
   Point baseline(
       center_left.x() + (center_right.x() - center_left.x())
-                        * altimeterBaselineRatio_,
+                        * layout_.altimeterBaselineRatio,
       center_left.y());
-  char buf[printBufSize_];
-  memset(buf, 0, sizeof(buf));
-  // Print the thousands string
-  if (thousands == 0) {
-    if (altitude < 0) {
-      // Print just a negative sign
-      snprintf(
-          buf,
-          printBufSize_,
-          "-");
-    } else {
-      // Leave the thousands blank
-    }
-  } else {
-    if (altitude < 0) {
-      snprintf(
-          buf,
-          printBufSize_,
-          "-%d",
-          thousands);
-    } else {
-      // Leave the thousands blank
-      snprintf(
-          buf,
-          printBufSize_,
-          "%d",
-          thousands);
-    }
-  }
-  draw_text(
-      screen_->cr(),
-      buf,
+  // The thousands of a negative altitude are keyed as negative numbers, so
+  // that below a thousand feet they can still show just a negative sign.
+  const std::string& thousandsText = state_.altitudeThousandsText.get(
+      altitude < 0 ? -1 - thousands : thousands,
+      [](char* first, char* last, int key) {
+        if (key < 0) {
+          *first++ = '-';
+          key = -1 - key;
+        }
+        // Leave the thousands blank
+        if (key == 0) {
+          return first;
+        }
+        return std::to_chars(first, last, key).ptr;
+      });
+  state_.altimeterGlyphsLarge->draw_text(
+      cr_,
+      thousandsText,
       Point(
-          baseline.x() - altimeterNumberGap_,
+          baseline.x() - layout_.altimeterNumberGap,
           baseline.y()),
-      TextReferencePoint::CENTER_RIGHT_UPPERCASE,
-      altimeterFontLarge_,
-      altimeterTextColor_);
-  snprintf(
-      buf,
-      printBufSize_,
-      "%03d",
-      last_three_digits);
-  draw_text(
-      screen_->cr(),
-      buf,
+      TextReferencePoint::CENTER_RIGHT_UPPERCASE);
+  const std::string& hundredsText = state_.altitudeHundredsText.get(
+      last_three_digits,
+      [](char* first, char* last, int digits) {
+        first[0] = (char) ('0' + digits / 100);
+        first[1] = (char) ('0' + digits / 10 % 10);
+        first[2] = (char) ('0' + digits % 10);
+        return first + 3;
+      });
+  state_.altimeterGlyphsSmall->draw_text(
+      cr_,
+      hundredsText,
       baseline,
-      TextReferencePoint::CENTER_LEFT_UPPERCASE,
-      altimeterFontSmall_,
-      altimeterTextColor_);
+      TextReferencePoint::CENTER_LEFT_UPPERCASE);
 }
 
 void PaintCycle::paintBaroSetting(
@@ -1138,49 +1671,89 @@ void PaintCycle::paintBaroSetting(
     Point bottom_left,
     Point bottom_right) {
   Point baseline(
-      center_left.x() + baroLeftOffset_,
+      center_left.x() + layout_.baroLeftOffset,
       center_left.y());
-  char buf[printBufSize_];
-  snprintf(
-      buf,
-      printBufSize_,
-      "%04.2f",
-      model_.settings()->baro_setting());
-  draw_text(
-      screen_->cr(),
-      buf,
+  state_.baroGlyphs->draw_text(
+      cr_,
+      layout_.baroSettingText,
       baseline,
-      TextReferencePoint::CENTER_LEFT_UPPERCASE,
-      baroFontSmall_,
-      baroTextColor_);
+      TextReferencePoint::CENTER_LEFT_UPPERCASE);
 }
 
 void PaintCycle::paintNoFlightData() {
   line(
-      screen_->cr(),
+      cr_,
       Point(0, 0),
-      Point(width_, height_),
-      noFlightDataStroke_);
+      Point(layout_.width, layout_.height),
+      layout_.noFlightDataStroke);
   line(
-      screen_->cr(),
-      Point(width_, 0),
-      Point(0, height_),
-      noFlightDataStroke_);
+      cr_,
+      Point(layout_.width, 0),
+      Point(0, layout_.height),
+      layout_.noFlightDataStroke);
 }
 
 void PaintCycle::paintUnitsAnnotation() {
-  std::stringstream buf;
-  buf << model_.settings()->speed_units();
-  if (model_.settings()->show_altimeter()) {
-    buf << " ft fpm inHg";
-  }
   draw_text(
-      screen_->cr(),
-      buf.str(),
-      Point(statusRegionMargin_, statusRegionMargin_),
+      cr_,
+      layout_.unitsAnnotation,
+      Point(layout_.statusRegionMargin, layout_.statusRegionMargin),
       TextReferencePoint ::TOP_LEFT,
-      statusTextFont_,
-      statusTextColor_);
+      layout_.statusTextFont,
+      layout_.statusTextColor);
+}
+
+void PaintCycle::paintPerfHud() {
+  // The text is formatted only when a new summary is made, once a second.
+  const FrameStats::Summary& stats = state_.options.frameStats->summary();
+  const std::string* lines[] = {
+      &state_.perfHudRates.get(
+          stats.sequence,
+          [&stats](char* first, char* last, unsigned long) {
+            first = writeNumber(first, last, stats.fps, 1);
+            first = writeText(first, last, " fps  ");
+            first = writeNumber(first, last, stats.telemetry_per_second, 0);
+            return writeText(first, last, "/s tlm");
+          }),
+      &state_.perfHudTimes.get(
+          stats.sequence,
+          [&stats](char* first, char* last, unsigned long) {
+            first = writeText(first, last, "paint ");
+            first = writeNumber(first, last, stats.paint_ms, 2);
+            first = writeText(first, last, "  flush ");
+            first = writeNumber(first, last, stats.flush_ms, 2);
+            return writeText(first, last, " ms");
+          }),
+      &state_.perfHudCounts.get(
+          stats.sequence,
+          [&stats](char* first, char* last, unsigned long) {
+            first = writeText(first, last, "events ");
+            first = writeNumber(first, last, (unsigned long) stats.event_queue_depth);
+            first = writeText(first, last, "  xruns ");
+            return writeNumber(first, last, stats.xruns);
+          }),
+      &state_.perfHudTransfer.get(
+          stats.sequence,
+          [&stats](char* first, char* last, unsigned long) {
+            first = writeText(first, last, "sent ");
+            first = writeNumber(first, last, stats.bytes_per_frame / 1024, 1);
+            return writeText(first, last, " kB/frame");
+          }),
+  };
+  // Beneath the units annotation. The last line is left out for screens
+  // that do not count what they send.
+  const int n = stats.bytes_per_frame > 0 ? 4 : 3;
+  for (int i = 0; i < n; i++) {
+    draw_text(
+        cr_,
+        *lines[i],
+        Point(
+            layout_.statusRegionMargin,
+            layout_.statusRegionMargin + (i + 1) * layout_.statusTextFont.size() * 1.25),
+        TextReferencePoint ::TOP_LEFT,
+        layout_.statusTextFont,
+        layout_.statusTextColor);
+  }
 }
 
 void PaintCycle::paintAdjusting() {
@@ -1188,31 +1761,30 @@ void PaintCycle::paintAdjusting() {
     return;
   }
   double rectHeight =
-    adjustingTextFont_.size() * 2.25 +
-    adjustingRegionMargin_ * 2;
+    layout_.adjustingTextFont.size() * 2.25 +
+    layout_.adjustingRegionMargin * 2;
   double rectWidth =
-    std::max(text_size(screen_->cr(), model_.settings()->adjustmentDisplayName(), adjustingTextFont_).w(),
-	     text_size(screen_->cr(), model_.settings()->adjustmentDisplayValue(), adjustingTextFont_).w()) +
-    adjustingRegionMargin_ * 2;
+    state_.adjustingTextWidth +
+    layout_.adjustingRegionMargin * 2;
   rectangle(
-      screen_->cr(),
-      Point(width_ - rectWidth, 0),
+      cr_,
+      Point(layout_.width - rectWidth, 0),
       Size(rectWidth, rectHeight),
       Color(0, 0, 0, 0.375));
   draw_text(
-      screen_->cr(),
-      model_.settings()->adjustmentDisplayName(),
-      Point(width_ - adjustingRegionMargin_, adjustingRegionMargin_),
+      cr_,
+      layout_.adjustmentName,
+      Point(layout_.width - layout_.adjustingRegionMargin, layout_.adjustingRegionMargin),
       TextReferencePoint ::TOP_RIGHT,
-      adjustingTextFont_,
-      adjustingTextColor_);
+      layout_.adjustingTextFont,
+      layout_.adjustingTextColor);
   draw_text(
-      screen_->cr(),
-      model_.settings()->adjustmentDisplayValue(),
-      Point(width_ - adjustingRegionMargin_, adjustingRegionMargin_ + adjustingTextFont_.size() * 1.25),
+      cr_,
+      layout_.adjustmentValue,
+      Point(layout_.width - layout_.adjustingRegionMargin, layout_.adjustingRegionMargin + layout_.adjustingTextFont.size() * 1.25),
       TextReferencePoint ::TOP_RIGHT,
-      adjustingTextFont_,
-      adjustingTextColor_);
+      layout_.adjustingTextFont,
+      layout_.adjustingTextColor);
 }
 
 } // namespace airball
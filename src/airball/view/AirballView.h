@@ -2,6 +2,7 @@
 #define AIRBALL_DISPLAY_H
 
 #include <cairo/cairo.h>
+#include <memory>
 
 #include "../model/Airdata.h"
 #include "../screen/AbstractScreen.h"
@@ -9,9 +10,76 @@
 
 namespace airball {
 
+class FrameStats;
+class QualityGovernor;
+class ViewState;
+
 class AirballView : public IView<IAirballModel> {
 public:
+  // What is left out of a frame at each tier of a QualityGovernor. Each tier
+  // also leaves out everything that the tiers above it do.
+  enum Quality {
+    // Everything is drawn.
+    FULL = 0,
+    // Lines and curves drawn afresh each frame are anti-aliased coarsely.
+    FAST_ANTIALIAS,
+    // Only the newest few raw airballs are drawn.
+    SHORT_TRAIL,
+    // The TAS rosette around the smooth airball is not drawn.
+    NO_TAS_ROSETTE,
+    // The display is decluttered, whatever the settings say.
+    DECLUTTER,
+    LOWEST_QUALITY = DECLUTTER,
+  };
+
+  // Ways of saving work from one frame to the next, which may be turned off
+  // to compare against drawing everything afresh.
+  struct Options {
+    // Draw the parts of the display that do not depend on the airdata into
+    // layers once, and copy the layers into each frame.
+    bool cacheLayers = true;
+    // Draw the numeric readouts from pre-rasterized glyphs.
+    bool glyphAtlas = true;
+    // Draw the smooth airball from pre-rendered sprites.
+    bool spriteCache = true;
+    // Draw the VSI strip on a thread of its own, at the same time as the
+    // airball area. Only done when drawing to an image in memory.
+    bool parallelRegions = true;
+    // On a rotated display, draw each frame upright and then turn it into
+    // the screen, rather than drawing through a rotated transformation. Only
+    // done when drawing to an image in memory.
+    bool uprightRotation = true;
+    // Draw the lines and arcs of the totem pole, the cow catcher, the
+    // airspeed limits and the VSI that share a stroke as one path. They are
+    // recorded as display lists either way.
+    bool displayLists = true;
+    // Keep the trail of raw airballs in an image that fades a step with each
+    // new ball, rather than drawing every ball of the trail in every frame.
+    // The trail fades exponentially rather than linearly, so this is off
+    // unless asked for.
+    bool phosphorTrail = false;
+    // If set, the tier of this governor is read at the start of each frame,
+    // and the frame is drawn at the Quality of that tier. Not owned.
+    const QualityGovernor* governor = nullptr;
+    // If set, a summary of these stats is drawn when the settings ask for
+    // it. Not owned.
+    const FrameStats* frameStats = nullptr;
+  };
+
+  AirballView();
+  explicit AirballView(const Options& options);
+  ~AirballView();
+
   void paint(const IAirballModel& m, IScreen* screen) override;
+
+  // How many times a sprite was found in the cache, or had to be rendered,
+  // since the view was created.
+  [[nodiscard]] int spriteHits() const;
+  [[nodiscard]] int spriteMisses() const;
+
+private:
+  // Drawing that is retained from one frame to the next.
+  std::unique_ptr<ViewState> state_;
 };
 
 } // namespace airball
@@ -0,0 +1,87 @@
+#include "cached_layer.h"
+
+namespace airball {
+
+CachedLayer::CachedLayer()
+    : cs_(nullptr),
+      cr_(nullptr),
+      width_(0),
+      height_(0),
+      opaque_(false),
+      valid_(false) {}
+
+CachedLayer::~CachedLayer() {
+  if (cr_ != nullptr) {
+    cairo_destroy(cr_);
+  }
+  if (cs_ != nullptr) {
+    cairo_surface_destroy(cs_);
+  }
+}
+
+static cairo_surface_t* create_layer_surface(
+    cairo_surface_t* target,
+    int width,
+    int height,
+    bool opaque) {
+  if (cairo_surface_get_type(target) == CAIRO_SURFACE_TYPE_IMAGE) {
+    return cairo_surface_create_similar_image(
+        target,
+        opaque ? cairo_image_surface_get_format(target) : CAIRO_FORMAT_ARGB32,
+        width,
+        height);
+  }
+  return cairo_surface_create_similar(
+      target,
+      opaque ? CAIRO_CONTENT_COLOR : CAIRO_CONTENT_COLOR_ALPHA,
+      width,
+      height);
+}
+
+cairo_t* CachedLayer::begin(
+    cairo_surface_t* target,
+    int width,
+    int height,
+    bool opaque) {
+  if (cs_ == nullptr ||
+      width != width_ ||
+      height != height_ ||
+      opaque != opaque_) {
+    if (cr_ != nullptr) {
+      cairo_destroy(cr_);
+    }
+    if (cs_ != nullptr) {
+      cairo_surface_destroy(cs_);
+    }
+    cs_ = create_layer_surface(target, width, height, opaque);
+    cr_ = cairo_create(cs_);
+    width_ = width;
+    height_ = height;
+    opaque_ = opaque;
+  }
+  valid_ = false;
+  cairo_save(cr_);
+  cairo_set_operator(cr_, CAIRO_OPERATOR_CLEAR);
+  cairo_paint(cr_);
+  cairo_restore(cr_);
+  return cr_;
+}
+
+void CachedLayer::end() {
+  cairo_surface_flush(cs_);
+  valid_ = true;
+}
+
+void CachedLayer::paint(cairo_t* cr) const {
+  cairo_save(cr);
+  // An opaque layer replaces what is beneath it, which lets the image backend
+  // use a plain copy rather than compositing.
+  cairo_set_operator(cr, opaque_ ? CAIRO_OPERATOR_SOURCE : CAIRO_OPERATOR_OVER);
+  cairo_set_source_surface(cr, cs_, 0, 0);
+  cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+  cairo_rectangle(cr, 0, 0, width_, height_);
+  cairo_fill(cr);
+  cairo_restore(cr);
+}
+
+}  // namespace airball
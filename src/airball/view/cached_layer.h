@@ -0,0 +1,57 @@
+#ifndef AIRBALL_VIEW_CACHED_LAYER_H
+#define AIRBALL_VIEW_CACHED_LAYER_H
+
+#include <cairo/cairo.h>
+
+namespace airball {
+
+/**
+ * An offscreen surface holding drawing that changes rarely. The drawing is
+ * rendered once into the layer and then copied into each frame until the
+ * layer is invalidated.
+ */
+class CachedLayer {
+public:
+  CachedLayer();
+  ~CachedLayer();
+
+  CachedLayer(const CachedLayer&) = delete;
+  CachedLayer& operator=(const CachedLayer&) = delete;
+
+  // Whether the layer holds a rendering that may be painted.
+  bool valid() const { return valid_; }
+
+  // Mark the layer as needing to be rendered again.
+  void invalidate() { valid_ = false; }
+
+  /**
+   * Begin rendering the layer.
+   *
+   * @param target the surface the layer will eventually be painted onto.
+   * @param width the width of the layer.
+   * @param height the height of the layer.
+   * @param opaque whether the layer covers everything beneath it. An opaque
+   *     layer uses the pixel format of the target, so that painting it is a
+   *     straight copy; otherwise the layer has an alpha channel.
+   * @return a Cairo context for drawing into the cleared layer.
+   */
+  cairo_t* begin(cairo_surface_t* target, int width, int height, bool opaque);
+
+  // Finish rendering the layer, after which it is valid.
+  void end();
+
+  // Paint the layer onto the given context at the user space origin.
+  void paint(cairo_t* cr) const;
+
+private:
+  cairo_surface_t* cs_;
+  cairo_t* cr_;
+  int width_;
+  int height_;
+  bool opaque_;
+  bool valid_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_VIEW_CACHED_LAYER_H
@@ -0,0 +1,45 @@
+#ifndef AIRBALL_VIEW_CACHED_TEXT_H
+#define AIRBALL_VIEW_CACHED_TEXT_H
+
+#include <string>
+
+namespace airball {
+
+/**
+ * Text formatted from a value, which is kept until it is asked for with a
+ * different value. Painting the same value frame after frame then formats
+ * nothing, and once the text has grown to its longest, allocates nothing.
+ */
+template <typename T>
+class CachedText {
+public:
+  // The longest text that may be formatted.
+  static constexpr size_t kMaxSize = 32;
+
+  /**
+   * @param value the value to format.
+   * @param format a function char*(char* first, char* last, const T& value)
+   *     that writes the text for the value into [first, last), with no
+   *     terminating null, and returns the end of what it wrote.
+   * @return the text for the value.
+   */
+  template <typename Format>
+  const std::string& get(const T& value, Format format) {
+    if (!valid_ || !(value == value_)) {
+      char buf[kMaxSize];
+      text_.assign(buf, format(buf, buf + kMaxSize, value));
+      value_ = value;
+      valid_ = true;
+    }
+    return text_;
+  }
+
+private:
+  bool valid_ = false;
+  T value_{};
+  std::string text_;
+};
+
+} // namespace airball
+
+#endif // AIRBALL_VIEW_CACHED_TEXT_H
@@ -0,0 +1,217 @@
+#include "display_list.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace airball {
+
+// Room left around each primitive for anti-aliasing.
+constexpr double kAntialiasMargin = 1;
+
+static bool intersects(const DisplayList::Rect& a, const DisplayList::Rect& b) {
+  return
+      a.x < b.x + b.w && b.x < a.x + a.w &&
+      a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+static DisplayList::Rect unite(const DisplayList::Rect& a, const DisplayList::Rect& b) {
+  const double x0 = std::min(a.x, b.x);
+  const double y0 = std::min(a.y, b.y);
+  const double x1 = std::max(a.x + a.w, b.x + b.w);
+  const double y1 = std::max(a.y + a.h, b.y + b.h);
+  return {x0, y0, x1 - x0, y1 - y0};
+}
+
+static bool same_color(const Color& a, const Color& b) {
+  return a.r() == b.r() && a.g() == b.g() && a.b() == b.b() && a.a() == b.a();
+}
+
+void DisplayList::clear() {
+  ops_.clear();
+  batches_.clear();
+}
+
+void DisplayList::line(const Point& start, const Point& end, const Stroke& stroke) {
+  const double m = stroke.width() / 2 + kAntialiasMargin;
+  const double x0 = std::min(start.x(), end.x()) - m;
+  const double y0 = std::min(start.y(), end.y()) - m;
+  add(Kind::LINE,
+      {stroke.color(), stroke.width()},
+      {x0, y0,
+       std::max(start.x(), end.x()) + m - x0,
+       std::max(start.y(), end.y()) + m - y0},
+      start.x(), start.y(), end.x(), end.y());
+}
+
+void DisplayList::arc(
+    const Point& center,
+    const double radius,
+    const double start_angle,
+    const double end_angle,
+    const Stroke& stroke) {
+  const double r = radius + stroke.width() / 2 + kAntialiasMargin;
+  add(Kind::ARC,
+      {stroke.color(), stroke.width()},
+      {center.x() - r, center.y() - r, 2 * r, 2 * r},
+      center.x(), center.y(), radius, start_angle, end_angle);
+}
+
+void DisplayList::rosette(
+    const Point& center,
+    const double radius,
+    const int num_petals,
+    const double petal_half_angle,
+    const double start_angle,
+    const Stroke& stroke) {
+  double angle_increment = 2 * M_PI / ((double) num_petals);
+  for (int i = 0; i < num_petals; i++) {
+    double angle = start_angle + i * angle_increment;
+    arc(center,
+        radius,
+        angle - petal_half_angle,
+        angle + petal_half_angle,
+        stroke);
+  }
+}
+
+void DisplayList::disc(const Point& center, const double radius, const Color& fill) {
+  const double r = radius + kAntialiasMargin;
+  add(Kind::DISC,
+      {fill, 0},
+      {center.x() - r, center.y() - r, 2 * r, 2 * r},
+      center.x(), center.y(), radius);
+}
+
+void DisplayList::rectangle(const Point& top_left, const Size& size, const Color& fill) {
+  add(Kind::RECTANGLE,
+      {fill, 0},
+      {top_left.x() - kAntialiasMargin,
+       top_left.y() - kAntialiasMargin,
+       size.w() + 2 * kAntialiasMargin,
+       size.h() + 2 * kAntialiasMargin},
+      top_left.x(), top_left.y(), size.w(), size.h());
+}
+
+void DisplayList::add(
+    Kind kind, const State& state, const Rect& bounds,
+    double v0, double v1, double v2, double v3, double v4) {
+  // Look back for a batch with the same state, as far as the first batch
+  // that this primitive overlaps, since it must still be drawn after that.
+  // Translucent primitives only join a batch they do not overlap, since
+  // overlapping parts of one path are only painted once.
+  int join = -1;
+  const int first = std::max(0, (int) batches_.size() - kMaxLookback);
+  for (int b = (int) batches_.size() - 1; b >= first; b--) {
+    const Batch& batch = batches_[b];
+    const bool overlaps = intersects(batch.bounds, bounds);
+    if (batch.state.width == state.width &&
+        same_color(batch.state.color, state.color) &&
+        (!overlaps || state.color.a() >= 1)) {
+      join = b;
+      break;
+    }
+    if (overlaps) {
+      break;
+    }
+  }
+  if (join < 0) {
+    join = (int) batches_.size();
+    batches_.push_back({state, bounds});
+  } else {
+    batches_[join].bounds = unite(batches_[join].bounds, bounds);
+  }
+  ops_.push_back({kind, (uint32_t) join, {v0, v1, v2, v3, v4}});
+}
+
+void DisplayList::path(cairo_t* cr, const Op& op) const {
+  switch (op.kind) {
+    case Kind::LINE:
+      cairo_move_to(cr, op.v[0], op.v[1]);
+      cairo_line_to(cr, op.v[2], op.v[3]);
+      break;
+    case Kind::ARC:
+      cairo_new_sub_path(cr);
+      cairo_arc(cr, op.v[0], op.v[1], op.v[2], op.v[3], op.v[4]);
+      break;
+    case Kind::DISC:
+      cairo_new_sub_path(cr);
+      cairo_arc(cr, op.v[0], op.v[1], op.v[2], 0, 2 * M_PI);
+      cairo_close_path(cr);
+      break;
+    case Kind::RECTANGLE:
+      cairo_rectangle(cr, op.v[0], op.v[1], op.v[2], op.v[3]);
+      break;
+  }
+}
+
+void DisplayList::draw(cairo_t* cr, const Op& op) const {
+  const State& state = batches_[op.batch].state;
+  switch (op.kind) {
+    case Kind::LINE:
+      airball::line(
+          cr,
+          Point(op.v[0], op.v[1]),
+          Point(op.v[2], op.v[3]),
+          Stroke(state.color, state.width));
+      break;
+    case Kind::ARC:
+      airball::arc(
+          cr,
+          Point(op.v[0], op.v[1]),
+          op.v[2],
+          op.v[3],
+          op.v[4],
+          Stroke(state.color, state.width));
+      break;
+    case Kind::DISC:
+      airball::disc(cr, Point(op.v[0], op.v[1]), op.v[2], state.color);
+      break;
+    case Kind::RECTANGLE:
+      airball::rectangle(
+          cr,
+          Point(op.v[0], op.v[1]),
+          Size(op.v[2], op.v[3]),
+          state.color);
+      break;
+  }
+}
+
+void DisplayList::replay(cairo_t* cr, bool batched) const {
+  if (!batched || render_backend() != RenderBackend::CAIRO) {
+    for (const Op& op : ops_) {
+      draw(cr, op);
+    }
+    return;
+  }
+
+  // Sort the primitives by batch, keeping the order within each batch.
+  starts_.assign(batches_.size() + 1, 0);
+  for (const Op& op : ops_) {
+    starts_[op.batch + 1]++;
+  }
+  for (size_t b = 0; b < batches_.size(); b++) {
+    starts_[b + 1] += starts_[b];
+  }
+  order_.resize(ops_.size());
+  for (uint32_t i = 0; i < ops_.size(); i++) {
+    order_[starts_[ops_[i].batch]++] = i;
+  }
+
+  size_t next = 0;
+  for (const Batch& batch : batches_) {
+    cairo_new_path(cr);
+    while (next < order_.size() && ops_[order_[next]].batch == &batch - batches_.data()) {
+      path(cr, ops_[order_[next]]);
+      next++;
+    }
+    if (batch.state.width > 0) {
+      Stroke(batch.state.color, batch.state.width).apply(cr);
+      cairo_stroke(cr);
+    } else {
+      batch.state.color.apply(cr);
+      cairo_fill(cr);
+    }
+  }
+}
+
+}  // namespace airball
@@ -0,0 +1,124 @@
+#ifndef AIRBALL_VIEW_DISPLAY_LIST_H
+#define AIRBALL_VIEW_DISPLAY_LIST_H
+
+#include <cairo/cairo.h>
+#include <cstdint>
+#include <vector>
+
+#include "widgets.h"
+
+namespace airball {
+
+/**
+ * A recording of stroked and filled primitives, to be drawn later.
+ *
+ * Primitives are gathered into batches that share a stroke or a fill as they
+ * are recorded. A primitive joins an earlier batch with the same state if
+ * nothing recorded since that batch overlaps it, so moving it earlier cannot
+ * change what is drawn. Each batch is then drawn as one Cairo path with one
+ * fill or stroke, rather than setting the state and drawing each primitive
+ * alone.
+ *
+ * Coordinates are in the user space of the context the list is replayed onto.
+ */
+class DisplayList {
+public:
+  struct Rect {
+    double x;
+    double y;
+    double w;
+    double h;
+  };
+
+  DisplayList() = default;
+
+  DisplayList(const DisplayList&) = delete;
+  DisplayList& operator=(const DisplayList&) = delete;
+
+  // Forget everything recorded, keeping the memory for the next recording.
+  void clear();
+
+  // Record primitives, as drawn by the functions of the same names in
+  // widgets.h.
+  void line(const Point& start, const Point& end, const Stroke& stroke);
+  void arc(
+      const Point& center,
+      const double radius,
+      const double start_angle,
+      const double end_angle,
+      const Stroke& stroke);
+  void rosette(
+      const Point& center,
+      const double radius,
+      const int num_petals,
+      const double petal_half_angle,
+      const double start_angle,
+      const Stroke& stroke);
+  void disc(const Point& center, const double radius, const Color& fill);
+  void rectangle(const Point& top_left, const Size& size, const Color& fill);
+
+  /**
+   * Draw the recording.
+   *
+   * @param cr the context to draw onto.
+   * @param batched whether to draw a batch at a time. Otherwise each
+   *     primitive is drawn alone, in the order it was recorded, exactly as
+   *     the functions in widgets.h would have drawn it. Primitives are also
+   *     drawn alone when the render backend is not Cairo, so that they can
+   *     take its fast paths.
+   */
+  void replay(cairo_t* cr, bool batched = true) const;
+
+  // The number of primitives recorded.
+  size_t size() const { return ops_.size(); }
+
+  // The number of batches the primitives were gathered into.
+  size_t batches() const { return batches_.size(); }
+
+private:
+  enum class Kind : uint8_t {
+    LINE,
+    ARC,
+    DISC,
+    RECTANGLE,
+  };
+
+  // The state shared by a batch: a stroke, or a fill if width is zero.
+  struct State {
+    Color color;
+    double width;
+  };
+
+  struct Op {
+    Kind kind;
+    uint32_t batch;
+    // LINE: x0, y0, x1, y1
+    // ARC: center x, y, radius, start and end angles
+    // DISC: center x, y, radius
+    // RECTANGLE: x, y, w, h
+    double v[5];
+  };
+
+  struct Batch {
+    State state;
+    Rect bounds;
+  };
+
+  // How many batches back a primitive may look for one to join.
+  static constexpr int kMaxLookback = 8;
+
+  void add(Kind kind, const State& state, const Rect& bounds,
+           double v0, double v1, double v2, double v3 = 0, double v4 = 0);
+  void path(cairo_t* cr, const Op& op) const;
+  void draw(cairo_t* cr, const Op& op) const;
+
+  std::vector<Op> ops_;
+  std::vector<Batch> batches_;
+  // The order in which ops_ are replayed, kept to save allocating it.
+  mutable std::vector<uint32_t> order_;
+  mutable std::vector<uint32_t> starts_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_VIEW_DISPLAY_LIST_H
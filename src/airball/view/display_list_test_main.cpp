@@ -0,0 +1,55 @@
+#include <iostream>
+
+#include "display_list.h"
+
+#define ASSERT_TRUE(x) if (!(x)) { std::cout << "Assertion failed " << __FILE__ << ":" << __LINE__ << std::endl; }
+
+using airball::Color;
+using airball::DisplayList;
+using airball::Point;
+using airball::Size;
+using airball::Stroke;
+
+int main(int arg, char** argv) {
+  const Stroke white(Color(255, 255, 255), 2);
+  const Stroke red(Color(255, 0, 0), 2);
+  const Stroke faint(Color(1.0, 1.0, 1.0, 0.5), 2);
+
+  {
+    // Primitives with one stroke share a batch.
+    DisplayList list;
+    for (int i = 0; i < 10; i++) {
+      list.line(Point(i * 10, 0), Point(i * 10 + 5, 50), white);
+    }
+    list.rosette(Point(50, 100), 20, 8, 0.1, 0, white);
+    ASSERT_TRUE(list.size() == 18);
+    ASSERT_TRUE(list.batches() == 1);
+
+    list.clear();
+    ASSERT_TRUE(list.size() == 0);
+    ASSERT_TRUE(list.batches() == 0);
+  }
+
+  {
+    // A primitive joins an earlier batch over others it does not overlap.
+    DisplayList list;
+    list.line(Point(0, 0), Point(10, 0), white);
+    list.line(Point(100, 100), Point(110, 100), red);
+    list.line(Point(0, 10), Point(10, 10), white);
+    ASSERT_TRUE(list.batches() == 2);
+
+    // But not over one it does overlap.
+    list.line(Point(105, 90), Point(105, 110), white);
+    ASSERT_TRUE(list.batches() == 3);
+  }
+
+  {
+    // Overlapping translucent primitives are not merged.
+    DisplayList list;
+    list.line(Point(0, 0), Point(10, 0), faint);
+    list.line(Point(5, -5), Point(5, 5), faint);
+    ASSERT_TRUE(list.batches() == 2);
+    list.line(Point(50, 50), Point(60, 50), faint);
+    ASSERT_TRUE(list.batches() == 2);
+  }
+}
@@ -0,0 +1,170 @@
+#include "glyph_atlas.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace airball {
+
+// Blank pixels around each glyph, so antialiased edges are not cut off.
+constexpr int kCellPadding = 1;
+
+// Tolerance for deciding that a transform maps pixels onto pixels.
+constexpr double kMatrixEpsilon = 1e-6;
+
+GlyphAtlas::GlyphAtlas(
+    const Font& font,
+    const Color& color,
+    const std::string& alphabet)
+    : font_(font),
+      color_(color),
+      glyphs_(256, Glyph{.present = false}),
+      cs_(nullptr),
+      cell_h_(0),
+      origin_y_(0) {
+  // Measure the glyphs using a scratch surface.
+  cairo_surface_t* scratch = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+  cairo_t* cr = cairo_create(scratch);
+  font_.apply(cr);
+
+  int atlas_w = 0;
+  int top = 0;
+  int bottom = 0;
+  for (char c : alphabet) {
+    char str[2] = { c, '\0' };
+    cairo_text_extents_t e;
+    cairo_text_extents(cr, str, &e);
+    Glyph& g = glyphs_[(unsigned char) c];
+    g.present = true;
+    g.x_bearing = e.x_bearing;
+    g.y_bearing = e.y_bearing;
+    g.width = e.width;
+    g.height = e.height;
+    g.x_advance = e.x_advance;
+    const int left = (int) floor(e.x_bearing);
+    const int right = (int) ceil(e.x_bearing + e.width);
+    g.origin_x = kCellPadding - left;
+    g.cell_w = right - left + 2 * kCellPadding;
+    g.cell_x = atlas_w;
+    atlas_w += g.cell_w;
+    top = std::min(top, (int) floor(e.y_bearing));
+    bottom = std::max(bottom, (int) ceil(e.y_bearing + e.height));
+  }
+  cairo_destroy(cr);
+  cairo_surface_destroy(scratch);
+
+  origin_y_ = kCellPadding - top;
+  cell_h_ = bottom - top + 2 * kCellPadding;
+
+  // Rasterize each glyph at a whole pixel origin within its cell, as Cairo
+  // does when drawing text onto an image surface.
+  cs_ = cairo_image_surface_create(
+      CAIRO_FORMAT_ARGB32,
+      std::max(atlas_w, 1),
+      std::max(cell_h_, 1));
+  cr = cairo_create(cs_);
+  font_.apply(cr);
+  color_.apply(cr);
+  for (char c : alphabet) {
+    char str[2] = { c, '\0' };
+    const Glyph& g = glyphs_[(unsigned char) c];
+    cairo_move_to(cr, g.cell_x + g.origin_x, origin_y_);
+    cairo_show_text(cr, str);
+  }
+  cairo_destroy(cr);
+  cairo_surface_flush(cs_);
+}
+
+GlyphAtlas::~GlyphAtlas() {
+  cairo_surface_destroy(cs_);
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::glyph(char c) const {
+  const Glyph* g = &glyphs_[(unsigned char) c];
+  return g->present ? g : nullptr;
+}
+
+bool GlyphAtlas::covers(const std::string& str) const {
+  return std::all_of(str.begin(), str.end(), [this](char c) {
+    return glyph(c) != nullptr;
+  });
+}
+
+bool GlyphAtlas::can_blit(cairo_t* cr) const {
+  // Cells may be copied pixel for pixel only if user space is device space
+  // turned by some multiple of 90 degrees and moved by whole pixels.
+  cairo_matrix_t m;
+  cairo_get_matrix(cr, &m);
+  auto is = [](double v, double target) {
+    return fabs(v - target) < kMatrixEpsilon;
+  };
+  auto is_unit = [&](double v) { return is(v, 1) || is(v, -1); };
+  auto is_whole = [&](double v) { return is(v, round(v)); };
+  const bool straight = is_unit(m.xx) && is_unit(m.yy) && is(m.xy, 0) && is(m.yx, 0);
+  const bool turned = is(m.xx, 0) && is(m.yy, 0) && is_unit(m.xy) && is_unit(m.yx);
+  return (straight || turned) && is_whole(m.x0) && is_whole(m.y0);
+}
+
+Size GlyphAtlas::text_size(cairo_t* cr, const std::string& str) const {
+  if (!covers(str)) {
+    return airball::text_size(cr, str, font_);
+  }
+  double pen = 0;
+  double x0 = 0, x1 = 0, y0 = 0, y1 = 0;
+  bool any = false;
+  for (char c : str) {
+    const Glyph* g = glyph(c);
+    if (g->width > 0 && g->height > 0) {
+      const double gx0 = pen + g->x_bearing;
+      const double gx1 = gx0 + g->width;
+      const double gy0 = g->y_bearing;
+      const double gy1 = gy0 + g->height;
+      if (any) {
+        x0 = std::min(x0, gx0);
+        x1 = std::max(x1, gx1);
+        y0 = std::min(y0, gy0);
+        y1 = std::max(y1, gy1);
+      } else {
+        x0 = gx0; x1 = gx1; y0 = gy0; y1 = gy1;
+        any = true;
+      }
+    }
+    pen += g->x_advance;
+  }
+  return {x1 - x0, y1 - y0};
+}
+
+void GlyphAtlas::draw_text(
+    cairo_t* cr,
+    const std::string& str,
+    const Point& point,
+    const TextReferencePoint ref) const {
+  if (!covers(str) || !can_blit(cr)) {
+    airball::draw_text(cr, str, point, ref, font_, color_);
+    return;
+  }
+  const Size size =
+      (ref == TOP_LEFT || ref == CENTER_LEFT_UPPERCASE)
+      ? Size()
+      : text_size(cr, str);
+  const Point origin = text_origin(point, ref, font_, size);
+  cairo_save(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+  double pen = origin.x();
+  const double gy = round(origin.y());
+  for (char c : str) {
+    const Glyph* g = glyph(c);
+    const double gx = round(pen);
+    cairo_set_source_surface(
+        cr,
+        cs_,
+        gx - g->origin_x - g->cell_x,
+        gy - origin_y_);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+    cairo_rectangle(cr, gx - g->origin_x, gy - origin_y_, g->cell_w, cell_h_);
+    cairo_fill(cr);
+    pen += g->x_advance;
+  }
+  cairo_restore(cr);
+}
+
+}  // namespace airball
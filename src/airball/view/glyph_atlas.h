@@ -0,0 +1,80 @@
+#ifndef AIRBALL_VIEW_GLYPH_ATLAS_H
+#define AIRBALL_VIEW_GLYPH_ATLAS_H
+
+#include <cairo/cairo.h>
+#include <string>
+#include <vector>
+
+#include "widgets.h"
+
+namespace airball {
+
+/**
+ * Pre-rasterized glyphs for a small alphabet in one Font and Color.
+ *
+ * Text made up entirely of characters in the alphabet is drawn by copying
+ * glyph cells from the atlas, skipping the shaping and rasterization that
+ * the Cairo text API does on every call. Any other text falls back to
+ * draw_text().
+ */
+class GlyphAtlas {
+public:
+  // The characters used by the numeric readouts.
+  static constexpr char kNumericAlphabet[] = "0123456789-.";
+
+  GlyphAtlas(
+      const Font& font,
+      const Color& color,
+      const std::string& alphabet = kNumericAlphabet);
+  ~GlyphAtlas();
+
+  GlyphAtlas(const GlyphAtlas&) = delete;
+  GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+  const Font& font() const { return font_; }
+  const Color& color() const { return color_; }
+
+  // Whether every character of the string can be drawn from the atlas.
+  bool covers(const std::string& str) const;
+
+  // Equivalent to text_size() in this atlas's font.
+  Size text_size(cairo_t* cr, const std::string& str) const;
+
+  // Equivalent to draw_text() in this atlas's font and color.
+  void draw_text(
+      cairo_t* cr,
+      const std::string& str,
+      const Point& point,
+      const TextReferencePoint ref) const;
+
+private:
+  struct Glyph {
+    bool present;
+    // Metrics as reported by cairo_text_extents().
+    double x_bearing;
+    double y_bearing;
+    double width;
+    double height;
+    double x_advance;
+    // The cell in the atlas holding the glyph, and the x offset of the glyph
+    // origin within that cell.
+    int cell_x;
+    int cell_w;
+    int origin_x;
+  };
+
+  const Glyph* glyph(char c) const;
+  bool can_blit(cairo_t* cr) const;
+
+  Font font_;
+  Color color_;
+  std::vector<Glyph> glyphs_;
+  cairo_surface_t* cs_;
+  // The height of every cell, and the y offset of the baseline within it.
+  int cell_h_;
+  int origin_y_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_VIEW_GLYPH_ATLAS_H
@@ -0,0 +1,116 @@
+#include "phosphor_trail.h"
+
+#include <algorithm>
+#include <math.h>
+
+#include "../util/pixel_kernels.h"
+
+namespace airball {
+
+PhosphorTrail::PhosphorTrail()
+    : cs_(nullptr),
+      cr_(nullptr),
+      width_(0),
+      height_(0),
+      factor_(0),
+      factorFor_(0),
+      haveNewest_(false) {}
+
+PhosphorTrail::~PhosphorTrail() {
+  if (cr_ != nullptr) {
+    cairo_destroy(cr_);
+  }
+  if (cs_ != nullptr) {
+    cairo_surface_destroy(cs_);
+  }
+}
+
+void PhosphorTrail::reset() {
+  haveNewest_ = false;
+}
+
+static bool same_ball(const IAirdata::Ball& a, const IAirdata::Ball& b) {
+  return
+      a.alpha() == b.alpha() &&
+      a.beta() == b.beta() &&
+      a.ias() == b.ias() &&
+      a.tas() == b.tas();
+}
+
+void PhosphorTrail::update(
+    cairo_surface_t* target,
+    int width,
+    int height,
+    const IAirdata::BallHistory& balls,
+    double brightness,
+    const DrawBall& draw) {
+  if (cs_ == nullptr || width != width_ || height != height_) {
+    if (cr_ != nullptr) {
+      cairo_destroy(cr_);
+    }
+    if (cs_ != nullptr) {
+      cairo_surface_destroy(cs_);
+    }
+    cs_ = cairo_surface_create_similar_image(target, CAIRO_FORMAT_A8, width, height);
+    cr_ = cairo_create(cs_);
+    // Each ball replaces the brightness beneath it, as an opaque ball drawn
+    // over older ones would.
+    cairo_set_operator(cr_, CAIRO_OPERATOR_SOURCE);
+    width_ = width;
+    height_ = height;
+    haveNewest_ = false;
+  }
+  if (balls.empty()) {
+    return;
+  }
+  if (balls.size() != factorFor_) {
+    // The oldest ball is drawn with 1 / n of the brightness of the newest.
+    const double n = (double) balls.size();
+    factor_ = n > 1 ? (int) floor(256 * pow(1 / n, 1 / (n - 1))) : 0;
+    factor_ = std::min(factor_, 255);
+    factorFor_ = balls.size();
+  }
+
+  size_t fresh = balls.size();
+  if (haveNewest_) {
+    for (size_t i = 0; i < balls.size(); i++) {
+      if (same_ball(balls[i], newest_)) {
+        fresh = i;
+        break;
+      }
+    }
+  }
+  if (fresh == balls.size()) {
+    cairo_save(cr_);
+    cairo_set_operator(cr_, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(cr_);
+    cairo_restore(cr_);
+  }
+  for (size_t i = fresh; i-- > 0; ) {
+    decay();
+    draw(cr_, i, brightness);
+  }
+  newest_ = balls[0];
+  haveNewest_ = true;
+}
+
+void PhosphorTrail::decay() {
+  cairo_surface_flush(cs_);
+  scaleBytes(
+      cairo_image_surface_get_data(cs_),
+      cairo_image_surface_get_stride(cs_),
+      width_,
+      height_,
+      factor_);
+  cairo_surface_mark_dirty(cs_);
+}
+
+void PhosphorTrail::paint(cairo_t* cr, const Color& color) const {
+  cairo_surface_flush(cs_);
+  cairo_save(cr);
+  color.apply(cr);
+  cairo_mask_surface(cr, cs_, 0, 0);
+  cairo_restore(cr);
+}
+
+}  // namespace airball
@@ -0,0 +1,75 @@
+#ifndef AIRBALL_VIEW_PHOSPHOR_TRAIL_H
+#define AIRBALL_VIEW_PHOSPHOR_TRAIL_H
+
+#include <cairo/cairo.h>
+#include <functional>
+#include <vector>
+
+#include "../model/IAirdata.h"
+#include "widgets.h"
+
+namespace airball {
+
+/**
+ * The trail of raw airballs, kept like the afterglow of a phosphor screen.
+ *
+ * The trail is an 8 bit image of brightness. For each new ball, the whole
+ * image is dimmed by a fixed factor and then the new ball is drawn at full
+ * brightness, so the cost of a frame does not depend on the length of the
+ * trail. The factor is chosen so that the oldest of the balls given fades to
+ * the brightness it would have as the last of a linear fade.
+ */
+class PhosphorTrail {
+public:
+  using DrawBall = std::function<void(cairo_t*, size_t, double)>;
+
+  PhosphorTrail();
+  ~PhosphorTrail();
+
+  PhosphorTrail(const PhosphorTrail&) = delete;
+  PhosphorTrail& operator=(const PhosphorTrail&) = delete;
+
+  // Forget the trail, so that the next update draws it afresh.
+  void reset();
+
+  /**
+   * Bring the trail up to date.
+   *
+   * @param target the surface the trail will be painted onto.
+   * @param width the width of the trail.
+   * @param height the height of the trail.
+   * @param balls the raw balls, newest first. Those newer than the newest
+   *     seen by the previous update are added to the trail; if that one is
+   *     no longer among them, the trail is drawn afresh.
+   * @param brightness the brightness of the newest ball.
+   * @param draw draws the ball at an index of the history into the trail,
+   *     with the brightness given as the alpha of its color.
+   */
+  void update(
+      cairo_surface_t* target,
+      int width,
+      int height,
+      const IAirdata::BallHistory& balls,
+      double brightness,
+      const DrawBall& draw);
+
+  // Paint the trail in the given color at the user space origin.
+  void paint(cairo_t* cr, const Color& color) const;
+
+private:
+  void decay();
+
+  cairo_surface_t* cs_;
+  cairo_t* cr_;
+  int width_;
+  int height_;
+  // The factor by which the trail is dimmed for each ball, out of 256.
+  int factor_;
+  size_t factorFor_;
+  bool haveNewest_;
+  IAirdata::Ball newest_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_VIEW_PHOSPHOR_TRAIL_H
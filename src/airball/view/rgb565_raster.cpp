@@ -0,0 +1,652 @@
+#include "rgb565_raster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace airball {
+namespace rgb565 {
+
+namespace {
+
+constexpr double kEpsilon = 1e-6;
+
+// Sub-scanlines per pixel row when filling polygons.
+constexpr int kPolygonSubRows = 4;
+
+// A 5-6-5 pixel spread over 32 bits as 00000gggggg00000rrrrr000000bbbbb, so
+// that each channel has room above it to be multiplied by a 5 bit alpha.
+constexpr uint32_t kSpreadMask = 0x07e0f81f;
+
+inline uint32_t spread(uint16_t p) {
+  return (p | ((uint32_t) p << 16)) & kSpreadMask;
+}
+
+inline uint16_t pack(uint32_t s) {
+  return (uint16_t) (s | (s >> 16));
+}
+
+inline double clamp01(double v) {
+  return v < 0 ? 0 : (v > 1 ? 1 : v);
+}
+
+inline bool near(double a, double b) {
+  return fabs(a - b) < kEpsilon;
+}
+
+inline bool near_integer(double a) {
+  return near(a, round(a));
+}
+
+// The pixels of the destination of a Cairo context, along with the parts of
+// the context's state that affect drawing.
+class Canvas {
+public:
+  // Prepare to draw into the destination of cr, returning false if that
+  // cannot be done without Cairo.
+  bool attach(cairo_t* cr);
+
+  // Flag the pixels in a rectangle as having been changed behind Cairo's back.
+  void mark_dirty(int xa, int ya, int xb, int yb);
+
+  Point to_device(const Point& p) const {
+    double x = p.x();
+    double y = p.y();
+    cairo_matrix_transform_point(&m_, &x, &y);
+    return {x, y};
+  }
+
+  // The angle by which user space is rotated relative to device space.
+  double rotation() const {
+    return atan2(m_.yx, m_.xx);
+  }
+
+  // Whether user space axes are parallel to device space axes.
+  bool axis_aligned() const {
+    return near(m_.xy, 0) || near(m_.xx, 0);
+  }
+
+  void set_color(const Color& c) {
+    const uint16_t p =
+        ((int) (c.r() * 255 + 0.5) >> 3) << 11 |
+        ((int) (c.g() * 255 + 0.5) >> 2) << 5 |
+        ((int) (c.b() * 255 + 0.5) >> 3);
+    pixel_ = p;
+    spread_ = spread(p);
+    alpha_ = c.a() * 32;
+  }
+
+  // Composite the color into a pixel at some coverage from 0 to 1. The
+  // pixel must lie within the clip.
+  void blend(int x, int y, double coverage) {
+    const int a = (int) (coverage * alpha_ + 0.5);
+    if (a <= 0) {
+      return;
+    }
+    uint16_t* p = data_ + y * stride_ + x;
+    if (a >= 32) {
+      *p = pixel_;
+      return;
+    }
+    const uint32_t bg = spread(*p);
+    *p = pack((((spread_ - bg) * a >> 5) + bg) & kSpreadMask);
+  }
+
+  // Composite the color at full coverage into the pixels from xa up to but
+  // not including xb of row y, clipped.
+  void span(int y, int xa, int xb) {
+    xa = std::max(xa, x0);
+    xb = std::min(xb, x1);
+    if (xa >= xb || y < y0 || y >= y1) {
+      return;
+    }
+    if (alpha_ >= 32 - kEpsilon) {
+      std::fill(data_ + y * stride_ + xa, data_ + y * stride_ + xb, pixel_);
+    } else {
+      for (int x = xa; x < xb; x++) {
+        blend(x, y, 1);
+      }
+    }
+  }
+
+  // The clip, in device pixels. The right and bottom edges are exclusive.
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+
+private:
+  cairo_surface_t* cs_;
+  uint16_t* data_;
+  int stride_;
+  cairo_matrix_t m_;
+  uint16_t pixel_;
+  uint32_t spread_;
+  double alpha_;
+};
+
+bool Canvas::attach(cairo_t* cr) {
+  cs_ = cairo_get_group_target(cr);
+  if (cairo_surface_get_type(cs_) != CAIRO_SURFACE_TYPE_IMAGE ||
+      cairo_image_surface_get_format(cs_) != CAIRO_FORMAT_RGB16_565) {
+    return false;
+  }
+  double ox, oy;
+  cairo_surface_get_device_offset(cs_, &ox, &oy);
+  if (ox != 0 || oy != 0) {
+    return false;
+  }
+  if (cairo_get_operator(cr) != CAIRO_OPERATOR_OVER) {
+    return false;
+  }
+
+  // Only rotations and translations, which preserve distances, are handled.
+  cairo_get_matrix(cr, &m_);
+  if (!near(m_.xx, m_.yy) ||
+      !near(m_.xy, -m_.yx) ||
+      !near(m_.xx * m_.xx + m_.yx * m_.yx, 1)) {
+    return false;
+  }
+
+  const int width = cairo_image_surface_get_width(cs_);
+  const int height = cairo_image_surface_get_height(cs_);
+  x0 = 0;
+  y0 = 0;
+  x1 = width;
+  y1 = height;
+
+  cairo_rectangle_list_t* clip = cairo_copy_clip_rectangle_list(cr);
+  bool ok = true;
+  if (clip->status == CAIRO_STATUS_SUCCESS) {
+    if (clip->num_rectangles == 0) {
+      // Everything is clipped away.
+      x1 = x0;
+    } else if (clip->num_rectangles == 1 && axis_aligned()) {
+      const cairo_rectangle_t& r = clip->rectangles[0];
+      Point a = to_device(Point(r.x, r.y));
+      Point b = to_device(Point(r.x + r.width, r.y + r.height));
+      double cx0 = std::min(a.x(), b.x());
+      double cy0 = std::min(a.y(), b.y());
+      double cx1 = std::max(a.x(), b.x());
+      double cy1 = std::max(a.y(), b.y());
+      if (near_integer(cx0) && near_integer(cy0) &&
+          near_integer(cx1) && near_integer(cy1)) {
+        x0 = std::max(x0, (int) round(cx0));
+        y0 = std::max(y0, (int) round(cy0));
+        x1 = std::min(x1, (int) round(cx1));
+        y1 = std::min(y1, (int) round(cy1));
+      } else {
+        ok = false;
+      }
+    } else {
+      ok = false;
+    }
+  } else if (clip->status == CAIRO_STATUS_CLIP_NOT_REPRESENTABLE) {
+    // Cairo also reports an unclipped context this way. That case is told
+    // apart by the clip extents covering the whole surface.
+    double ex0, ey0, ex1, ey1;
+    cairo_clip_extents(cr, &ex0, &ey0, &ex1, &ey1);
+    Point a = to_device(Point(ex0, ey0));
+    Point b = to_device(Point(ex1, ey1));
+    ok = std::min(a.x(), b.x()) <= 0 &&
+         std::min(a.y(), b.y()) <= 0 &&
+         std::max(a.x(), b.x()) >= width &&
+         std::max(a.y(), b.y()) >= height;
+  } else {
+    ok = false;
+  }
+  cairo_rectangle_list_destroy(clip);
+  if (!ok) {
+    return false;
+  }
+
+  cairo_surface_flush(cs_);
+  data_ = (uint16_t*) cairo_image_surface_get_data(cs_);
+  stride_ = cairo_image_surface_get_stride(cs_) / sizeof(uint16_t);
+  return true;
+}
+
+void Canvas::mark_dirty(int xa, int ya, int xb, int yb) {
+  xa = std::max(xa, x0);
+  ya = std::max(ya, y0);
+  xb = std::min(xb, x1);
+  yb = std::min(yb, y1);
+  if (xa < xb && ya < yb) {
+    cairo_surface_mark_dirty_rectangle(cs_, xa, ya, xb - xa, yb - ya);
+  }
+}
+
+// The range of x on the horizontal line at y within distance r of a point.
+bool point_interval(
+    double px, double py, double y, double r, double& lo, double& hi) {
+  const double dy = y - py;
+  if (fabs(dy) > r) {
+    return false;
+  }
+  const double h = sqrt(r * r - dy * dy);
+  lo = px - h;
+  hi = px + h;
+  return true;
+}
+
+// Narrow [lo, hi] to the values of x for which k * x + b lies in [a0, a1].
+bool narrow_linear(
+    double k, double b, double a0, double a1, double& lo, double& hi) {
+  if (fabs(k) < kEpsilon) {
+    return b >= a0 && b <= a1;
+  }
+  double xa = (a0 - b) / k;
+  double xb = (a1 - b) / k;
+  if (xa > xb) {
+    std::swap(xa, xb);
+  }
+  lo = std::max(lo, xa);
+  hi = std::min(hi, xb);
+  return lo <= hi;
+}
+
+// A line segment, used to find the pixels within some distance of it.
+class Segment {
+public:
+  Segment(const Point& a, const Point& b)
+      : ax_(a.x()), ay_(a.y()), bx_(b.x()), by_(b.y()) {
+    const double dx = bx_ - ax_;
+    const double dy = by_ - ay_;
+    len_ = sqrt(dx * dx + dy * dy);
+    ux_ = len_ < kEpsilon ? 1 : dx / len_;
+    uy_ = len_ < kEpsilon ? 0 : dy / len_;
+  }
+
+  double left() const { return std::min(ax_, bx_); }
+  double right() const { return std::max(ax_, bx_); }
+  double top() const { return std::min(ay_, by_); }
+  double bottom() const { return std::max(ay_, by_); }
+
+  double distance(double x, double y) const {
+    const double t = std::clamp((x - ax_) * ux_ + (y - ay_) * uy_, 0.0, len_);
+    const double dx = x - (ax_ + t * ux_);
+    const double dy = y - (ay_ + t * uy_);
+    return sqrt(dx * dx + dy * dy);
+  }
+
+  // The range of x on the horizontal line at y within distance r. Since the
+  // set of such points is convex, this is the union of the ranges near each
+  // end and near the body of the segment.
+  bool interval(double y, double r, double& lo, double& hi) const {
+    bool any = false;
+    double a, b;
+    auto add = [&]() {
+      lo = any ? std::min(lo, a) : a;
+      hi = any ? std::max(hi, b) : b;
+      any = true;
+    };
+    if (point_interval(ax_, ay_, y, r, a, b)) {
+      add();
+    }
+    if (point_interval(bx_, by_, y, r, a, b)) {
+      add();
+    }
+    if (len_ >= kEpsilon) {
+      // Points whose projection falls on the segment, and whose distance
+      // from its line is at most r, as functions of x - ax_.
+      a = -INFINITY;
+      b = INFINITY;
+      const double ry = y - ay_;
+      if (narrow_linear(ux_, ry * uy_, 0, len_, a, b) &&
+          narrow_linear(-uy_, ry * ux_, -r, r, a, b)) {
+        a += ax_;
+        b += ax_;
+        add();
+      }
+    }
+    return any;
+  }
+
+private:
+  double ax_, ay_, bx_, by_;
+  double ux_, uy_;
+  double len_;
+};
+
+// Fill the pixels within radius of a segment, which may be of zero length.
+void fill_near_segment(Canvas& c, const Segment& s, double radius) {
+  const double outer = radius + 0.5;
+  const double inner = radius - 0.5;
+  const int ya = std::max(c.y0, (int) ceil(s.top() - outer));
+  const int yb = std::min(c.y1 - 1, (int) floor(s.bottom() + outer));
+  for (int py = ya; py <= yb; py++) {
+    const double yc = py + 0.5;
+    double lo, hi;
+    if (!s.interval(yc, outer, lo, hi)) {
+      continue;
+    }
+    const int xa = std::max(c.x0, (int) ceil(lo - 0.5));
+    const int xb = std::min(c.x1 - 1, (int) floor(hi - 0.5));
+    // Pixels whose centers are within the inner range are fully covered.
+    int sa = xb + 1;
+    int sb = xb;
+    double ilo, ihi;
+    if (inner > 0 && s.interval(yc, inner, ilo, ihi)) {
+      sa = std::max(xa, (int) ceil(ilo - 0.5));
+      sb = std::min(xb, (int) floor(ihi - 0.5));
+      if (sa > sb) {
+        sa = xb + 1;
+        sb = xb;
+      }
+    }
+    for (int px = xa; px <= xb; px++) {
+      if (px == sa) {
+        c.span(py, sa, sb + 1);
+        px = sb;
+        continue;
+      }
+      c.blend(px, py, clamp01(outer - s.distance(px + 0.5, yc)));
+    }
+  }
+  c.mark_dirty(
+      (int) floor(s.left() - outer), ya,
+      (int) ceil(s.right() + outer), yb + 1);
+}
+
+}  // namespace
+
+bool line(
+    cairo_t* cr,
+    const Point& start,
+    const Point& end,
+    const Stroke& stroke) {
+  Canvas c;
+  if (!c.attach(cr)) {
+    return false;
+  }
+  c.set_color(stroke.color());
+  fill_near_segment(c, Segment(c.to_device(start), c.to_device(end)), stroke.width() / 2);
+  cairo_new_path(cr);
+  return true;
+}
+
+bool disc(
+    cairo_t* cr,
+    const Point& center,
+    const double radius,
+    const Color& fill) {
+  Canvas c;
+  if (!c.attach(cr)) {
+    return false;
+  }
+  c.set_color(fill);
+  const Point p = c.to_device(center);
+  fill_near_segment(c, Segment(p, p), radius);
+  cairo_new_path(cr);
+  return true;
+}
+
+bool arc(
+    cairo_t* cr,
+    const Point& center,
+    const double radius,
+    const double start_angle,
+    const double end_angle,
+    const Stroke& stroke) {
+  Canvas c;
+  if (!c.attach(cr)) {
+    return false;
+  }
+  c.set_color(stroke.color());
+
+  const Point ctr = c.to_device(center);
+  const double cx = ctr.x();
+  const double cy = ctr.y();
+  const double half_width = stroke.width() / 2;
+  const double outer = half_width + 0.5;
+
+  // Like cairo_arc(), sweep in the direction of increasing angle.
+  const double a0 = start_angle + c.rotation();
+  double a1 = end_angle + c.rotation();
+  while (a1 < a0) {
+    a1 += 2 * M_PI;
+  }
+  const double sweep = a1 - a0;
+  const bool full = sweep >= 2 * M_PI;
+  const double u0x = cos(a0), u0y = sin(a0);
+  const double u1x = cos(a1), u1y = sin(a1);
+  const double p0x = cx + radius * u0x, p0y = cy + radius * u0y;
+  const double p1x = cx + radius * u1x, p1y = cy + radius * u1y;
+
+  auto in_sweep = [&](double vx, double vy) {
+    if (full) {
+      return true;
+    }
+    if (sweep <= M_PI) {
+      return u0x * vy - u0y * vx >= 0 && vx * u1y - vy * u1x >= 0;
+    }
+    return !(u1x * vy - u1y * vx > 0 && vx * u0y - vy * u0x > 0);
+  };
+
+  // The bounds of the arc are its ends, plus any of the extreme points of
+  // the circle that fall within the sweep.
+  double bx0 = std::min(p0x, p1x);
+  double bx1 = std::max(p0x, p1x);
+  double by0 = std::min(p0y, p1y);
+  double by1 = std::max(p0y, p1y);
+  if (in_sweep(1, 0)) bx1 = cx + radius;
+  if (in_sweep(-1, 0)) bx0 = cx - radius;
+  if (in_sweep(0, 1)) by1 = cy + radius;
+  if (in_sweep(0, -1)) by0 = cy - radius;
+
+  const int xmin = std::max(c.x0, (int) ceil(bx0 - outer));
+  const int xmax = std::min(c.x1 - 1, (int) floor(bx1 + outer));
+  const int ya = std::max(c.y0, (int) ceil(by0 - outer));
+  const int yb = std::min(c.y1 - 1, (int) floor(by1 + outer));
+
+  auto cover = [&](int px, int py) {
+    const double vx = px + 0.5 - cx;
+    const double vy = py + 0.5 - cy;
+    double d;
+    if (in_sweep(vx, vy)) {
+      d = fabs(sqrt(vx * vx + vy * vy) - radius);
+    } else {
+      const double d0 = hypot(px + 0.5 - p0x, py + 0.5 - p0y);
+      const double d1 = hypot(px + 0.5 - p1x, py + 0.5 - p1y);
+      d = std::min(d0, d1);
+    }
+    c.blend(px, py, clamp01(outer - d));
+  };
+
+  for (int py = ya; py <= yb; py++) {
+    const double yc = py + 0.5;
+    double lo, hi;
+    if (!point_interval(cx, cy, yc, radius + outer, lo, hi)) {
+      continue;
+    }
+    int xa = std::max(xmin, (int) ceil(lo - 0.5));
+    int xb = std::min(xmax, (int) floor(hi - 0.5));
+    // Skip the hole in the middle of the ring.
+    double ilo, ihi;
+    if (radius - outer > 0 &&
+        point_interval(cx, cy, yc, radius - outer, ilo, ihi)) {
+      const int ha = (int) floor(ilo - 0.5) + 1;
+      const int hb = (int) ceil(ihi - 0.5) - 1;
+      for (int px = xa; px <= std::min(xb, ha - 1); px++) {
+        cover(px, py);
+      }
+      for (int px = std::max(xa, hb + 1); px <= xb; px++) {
+        cover(px, py);
+      }
+    } else {
+      for (int px = xa; px <= xb; px++) {
+        cover(px, py);
+      }
+    }
+  }
+  c.mark_dirty(xmin, ya, xmax + 1, yb + 1);
+  cairo_new_path(cr);
+  return true;
+}
+
+bool rectangle(
+    cairo_t* cr,
+    const Point& top_left,
+    const Size& size,
+    const Color& fill) {
+  Canvas c;
+  if (!c.attach(cr)) {
+    return false;
+  }
+  if (!c.axis_aligned()) {
+    const Point corners[] = {
+        top_left,
+        Point(top_left.x() + size.w(), top_left.y()),
+        Point(top_left.x() + size.w(), top_left.y() + size.h()),
+        Point(top_left.x(), top_left.y() + size.h()),
+    };
+    return rgb565::shape(cr, 4, corners, fill);
+  }
+  c.set_color(fill);
+
+  const Point a = c.to_device(top_left);
+  const Point b = c.to_device(Point(top_left.x() + size.w(), top_left.y() + size.h()));
+  const double rx0 = std::max(std::min(a.x(), b.x()), (double) c.x0);
+  const double ry0 = std::max(std::min(a.y(), b.y()), (double) c.y0);
+  const double rx1 = std::min(std::max(a.x(), b.x()), (double) c.x1);
+  const double ry1 = std::min(std::max(a.y(), b.y()), (double) c.y1);
+  if (rx1 > rx0 && ry1 > ry0) {
+    // Columns from sa up to sb are fully covered horizontally, and at most
+    // one partly covered column lies on either side.
+    const int pxa = (int) floor(rx0);
+    const int pxb = (int) ceil(rx1) - 1;
+    const int sa = (int) ceil(rx0);
+    const int sb = (int) floor(rx1);
+    const int pya = (int) floor(ry0);
+    const int pyb = (int) ceil(ry1) - 1;
+    for (int py = pya; py <= pyb; py++) {
+      const double cy = std::min(ry1, py + 1.0) - std::max(ry0, (double) py);
+      if (sa > sb) {
+        c.blend(pxa, py, (rx1 - rx0) * cy);
+        continue;
+      }
+      if (pxa < sa) {
+        c.blend(pxa, py, (sa - rx0) * cy);
+      }
+      if (cy >= 1 - kEpsilon) {
+        c.span(py, sa, sb);
+      } else {
+        for (int px = sa; px < sb; px++) {
+          c.blend(px, py, cy);
+        }
+      }
+      if (pxb >= sb) {
+        c.blend(pxb, py, (rx1 - sb) * cy);
+      }
+    }
+    c.mark_dirty(pxa, pya, pxb + 1, pyb + 1);
+  }
+  cairo_new_path(cr);
+  return true;
+}
+
+bool shape(
+    cairo_t* cr,
+    const int numCorners,
+    const Point corners[],
+    const Color& fill) {
+  Canvas c;
+  if (!c.attach(cr)) {
+    return false;
+  }
+  c.set_color(fill);
+
+  thread_local std::vector<Point> points;
+  thread_local std::vector<std::pair<double, int>> crossings;
+  thread_local std::vector<float> coverage;
+
+  points.clear();
+  double top = INFINITY;
+  double bottom = -INFINITY;
+  for (int i = 0; i < numCorners; i++) {
+    points.push_back(c.to_device(corners[i]));
+    top = std::min(top, points.back().y());
+    bottom = std::max(bottom, points.back().y());
+  }
+  if (numCorners < 3 || c.x0 >= c.x1) {
+    cairo_new_path(cr);
+    return true;
+  }
+  coverage.assign(c.x1 - c.x0, 0);
+
+  // Add sub-scanline coverage between two x coordinates.
+  int touched_lo, touched_hi;
+  auto add_span = [&](double xa, double xb, float weight) {
+    xa = std::max(xa, (double) c.x0);
+    xb = std::min(xb, (double) c.x1);
+    if (xb <= xa) {
+      return;
+    }
+    const int ia = (int) floor(xa);
+    const int ib = (int) floor(xb);
+    touched_lo = std::min(touched_lo, ia);
+    touched_hi = std::max(touched_hi, std::min(ib, c.x1 - 1));
+    if (ia == ib) {
+      coverage[ia - c.x0] += (xb - xa) * weight;
+      return;
+    }
+    coverage[ia - c.x0] += (ia + 1 - xa) * weight;
+    for (int i = ia + 1; i < ib; i++) {
+      coverage[i - c.x0] += weight;
+    }
+    if (ib < c.x1) {
+      coverage[ib - c.x0] += (xb - ib) * weight;
+    }
+  };
+
+  const int ya = std::max(c.y0, (int) floor(top));
+  const int yb = std::min(c.y1 - 1, (int) ceil(bottom) - 1);
+  int dirty_lo = c.x1;
+  int dirty_hi = c.x0 - 1;
+  for (int py = ya; py <= yb; py++) {
+    touched_lo = c.x1;
+    touched_hi = c.x0 - 1;
+    for (int k = 0; k < kPolygonSubRows; k++) {
+      const double sy = py + (k + 0.5) / kPolygonSubRows;
+      crossings.clear();
+      for (int i = 0; i < numCorners; i++) {
+        const Point& a = points[i];
+        const Point& b = points[(i + 1) % numCorners];
+        if (a.y() == b.y() ||
+            sy < std::min(a.y(), b.y()) ||
+            sy >= std::max(a.y(), b.y())) {
+          continue;
+        }
+        const double x = a.x() + (sy - a.y()) * (b.x() - a.x()) / (b.y() - a.y());
+        crossings.emplace_back(x, b.y() > a.y() ? 1 : -1);
+      }
+      std::sort(crossings.begin(), crossings.end());
+      // Fill with the nonzero winding rule, Cairo's default.
+      int winding = 0;
+      double start = 0;
+      for (const auto& [x, dir] : crossings) {
+        const int before = winding;
+        winding += dir;
+        if (before == 0 && winding != 0) {
+          start = x;
+        } else if (before != 0 && winding == 0) {
+          add_span(start, x, 1.0f / kPolygonSubRows);
+        }
+      }
+    }
+    for (int px = touched_lo; px <= touched_hi; px++) {
+      float& cov = coverage[px - c.x0];
+      c.blend(px, py, std::min(cov, 1.0f));
+      cov = 0;
+    }
+    dirty_lo = std::min(dirty_lo, touched_lo);
+    dirty_hi = std::max(dirty_hi, touched_hi);
+  }
+  c.mark_dirty(dirty_lo, ya, dirty_hi + 1, yb + 1);
+  cairo_new_path(cr);
+  return true;
+}
+
+}  // namespace rgb565
+}  // namespace airball
@@ -0,0 +1,65 @@
+#ifndef AIRBALL_VIEW_RGB565_RASTER_H
+#define AIRBALL_VIEW_RGB565_RASTER_H
+
+#include <cairo/cairo.h>
+
+#include "widgets.h"
+
+namespace airball {
+
+/**
+ * A rasterizer that draws the widget primitives straight into the pixels of
+ * a CAIRO_FORMAT_RGB16_565 image surface, bypassing Cairo.
+ *
+ * Discs, lines and arcs are anti-aliased analytically from the distance of
+ * each pixel center to the shape, with interior spans filled without any
+ * per-pixel arithmetic. Rectangles use exact area coverage, and polygons
+ * four sub-scanlines per row. Compositing is done in fixed point on packed
+ * 5-6-5 pixels.
+ *
+ * Each function returns false, having drawn nothing, if it cannot honor the
+ * state of the Cairo context: a target that is not an RGB565 image surface,
+ * a transform other than a rotation and translation, a clip that is not a
+ * single pixel-aligned rectangle, or an operator other than OVER. The caller
+ * then draws with Cairo instead. On success, the current path of the context
+ * is cleared, as stroking or filling would have done.
+ */
+namespace rgb565 {
+
+bool line(
+    cairo_t* cr,
+    const Point& start,
+    const Point& end,
+    const Stroke& stroke);
+
+bool arc(
+    cairo_t* cr,
+    const Point& center,
+    const double radius,
+    const double start_angle,
+    const double end_angle,
+    const Stroke& stroke);
+
+bool disc(
+    cairo_t* cr,
+    const Point& center,
+    const double radius,
+    const Color& fill);
+
+bool rectangle(
+    cairo_t* cr,
+    const Point& top_left,
+    const Size& size,
+    const Color& fill);
+
+bool shape(
+    cairo_t* cr,
+    const int numCorners,
+    const Point corners[],
+    const Color& fill);
+
+}  // namespace rgb565
+
+}  // namespace airball
+
+#endif  // AIRBALL_VIEW_RGB565_RASTER_H
@@ -0,0 +1,94 @@
+#include "sprite_cache.h"
+
+#include <cmath>
+
+namespace airball {
+
+SpriteCache::SpriteCache(size_t budget_bytes)
+    : budget_bytes_(budget_bytes),
+      used_bytes_(0),
+      hits_(0),
+      misses_(0) {}
+
+SpriteCache::~SpriteCache() {
+  clear();
+}
+
+void SpriteCache::clear() {
+  for (auto& s : sprites_) {
+    cairo_surface_destroy(s.cs);
+  }
+  sprites_.clear();
+  used_bytes_ = 0;
+}
+
+size_t SpriteCache::bytes(int extent) {
+  const size_t side = 2 * extent + 2;
+  return side * side * 4;
+}
+
+void SpriteCache::paint(
+    cairo_t* cr,
+    Key key,
+    const Point& center,
+    int extent,
+    const std::function<void(cairo_t* cr, const Point& center)>& draw) {
+  // Split the center into a whole pixel and a phase, rounding to the nearest
+  // phase.
+  double ix = floor(center.x());
+  double iy = floor(center.y());
+  key.phaseX = (int) round((center.x() - ix) * kPhases);
+  key.phaseY = (int) round((center.y() - iy) * kPhases);
+  if (key.phaseX == kPhases) {
+    key.phaseX = 0;
+    ix++;
+  }
+  if (key.phaseY == kPhases) {
+    key.phaseY = 0;
+    iy++;
+  }
+
+  auto it = sprites_.begin();
+  while (it != sprites_.end() && !(it->key == key && it->extent >= extent)) {
+    ++it;
+  }
+
+  if (it != sprites_.end()) {
+    hits_++;
+    sprites_.splice(sprites_.begin(), sprites_, it);
+  } else {
+    misses_++;
+    const size_t needed = bytes(extent);
+    while (!sprites_.empty() && used_bytes_ + needed > budget_bytes_) {
+      used_bytes_ -= bytes(sprites_.back().extent);
+      cairo_surface_destroy(sprites_.back().cs);
+      sprites_.pop_back();
+    }
+    const int side = 2 * extent + 2;
+    cairo_surface_t* cs = cairo_surface_create_similar_image(
+        cairo_get_target(cr), CAIRO_FORMAT_ARGB32, side, side);
+    cairo_t* sprite_cr = cairo_create(cs);
+    draw(
+        sprite_cr,
+        Point(
+            extent + (double) key.phaseX / kPhases,
+            extent + (double) key.phaseY / kPhases));
+    cairo_destroy(sprite_cr);
+    cairo_surface_flush(cs);
+    sprites_.push_front({key, extent, cs});
+    used_bytes_ += needed;
+  }
+
+  const Sprite& s = sprites_.front();
+  const double x = ix - s.extent;
+  const double y = iy - s.extent;
+  const int side = 2 * s.extent + 2;
+  cairo_save(cr);
+  cairo_set_source_surface(cr, s.cs, x, y);
+  cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+  cairo_rectangle(cr, x, y, side, side);
+  cairo_fill(cr);
+  cairo_restore(cr);
+}
+
+}  // namespace airball
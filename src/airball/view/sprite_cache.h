@@ -0,0 +1,93 @@
+#ifndef AIRBALL_VIEW_SPRITE_CACHE_H
+#define AIRBALL_VIEW_SPRITE_CACHE_H
+
+#include <cairo/cairo.h>
+#include <functional>
+#include <list>
+
+#include "widgets.h"
+
+namespace airball {
+
+/**
+ * A cache of pre-rendered images of what is drawn around the airball, keyed
+ * by the values that determine their appearance.
+ *
+ * Each sprite is square, with the center of the airball near its middle.
+ * The center is offset from the middle by a fraction of a pixel, so that
+ * sprites can be copied to whole pixel positions and still place the
+ * airball within a fraction of a pixel of where it belongs. That fraction,
+ * the "phase", is part of the key.
+ *
+ * The least recently used sprites are discarded to stay within a budget of
+ * memory.
+ */
+class SpriteCache {
+public:
+  // The number of sub-pixel positions, in each direction, at which sprites
+  // are rendered.
+  static constexpr int kPhases = 4;
+
+  // Everything that determines the appearance of a sprite, apart from the
+  // settings, on any change to which the cache must be cleared.
+  struct Key {
+    // Which of the airspeed limit markings is drawn.
+    int limits = 0;
+    // Whether the sprite is drawn with fast anti-aliasing.
+    int antialias = 0;
+    int phaseX = 0;
+    int phaseY = 0;
+
+    bool operator==(const Key& other) const = default;
+  };
+
+  explicit SpriteCache(size_t budget_bytes);
+  ~SpriteCache();
+
+  SpriteCache(const SpriteCache&) = delete;
+  SpriteCache& operator=(const SpriteCache&) = delete;
+
+  // Discard all sprites.
+  void clear();
+
+  /**
+   * Paint a sprite, rendering it first if it is not in the cache.
+   *
+   * @param cr the context to paint into.
+   * @param key the key of the sprite, apart from the phase, which is set
+   *     from the position.
+   * @param center the position of the center of the airball.
+   * @param extent the greatest distance from the center of anything drawn.
+   * @param draw a function to render the sprite. It is given a context for
+   *     a cleared sprite, and the position of the center within it.
+   */
+  void paint(
+      cairo_t* cr,
+      Key key,
+      const Point& center,
+      int extent,
+      const std::function<void(cairo_t* cr, const Point& center)>& draw);
+
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+
+private:
+  struct Sprite {
+    Key key;
+    int extent;
+    cairo_surface_t* cs;
+  };
+
+  static size_t bytes(int extent);
+
+  const size_t budget_bytes_;
+  size_t used_bytes_;
+  // Most recently used first.
+  std::list<Sprite> sprites_;
+  int hits_;
+  int misses_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_VIEW_SPRITE_CACHE_H
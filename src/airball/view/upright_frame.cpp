@@ -0,0 +1,72 @@
+#include "upright_frame.h"
+
+#include "../util/pixel_kernels.h"
+
+namespace airball {
+
+UprightFrame::UprightFrame()
+    : cs_(nullptr),
+      cr_(nullptr) {}
+
+UprightFrame::~UprightFrame() {
+  if (cr_ != nullptr) {
+    cairo_destroy(cr_);
+  }
+  if (cs_ != nullptr) {
+    cairo_surface_destroy(cs_);
+  }
+}
+
+static bool is_32_bit(cairo_format_t format) {
+  return format == CAIRO_FORMAT_ARGB32 || format == CAIRO_FORMAT_RGB24;
+}
+
+bool UprightFrame::supports(cairo_surface_t* target, int width, int height) {
+  if (cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE) {
+    return false;
+  }
+  const cairo_format_t format = cairo_image_surface_get_format(target);
+  return
+      (is_32_bit(format) || format == CAIRO_FORMAT_RGB16_565) &&
+      cairo_image_surface_get_width(target) == height &&
+      cairo_image_surface_get_height(target) == width;
+}
+
+cairo_t* UprightFrame::begin(cairo_surface_t* target, int width, int height) {
+  const cairo_format_t format = cairo_image_surface_get_format(target);
+  if (cs_ == nullptr ||
+      cairo_image_surface_get_width(cs_) != width ||
+      cairo_image_surface_get_height(cs_) != height ||
+      cairo_image_surface_get_format(cs_) != format) {
+    if (cr_ != nullptr) {
+      cairo_destroy(cr_);
+    }
+    if (cs_ != nullptr) {
+      cairo_surface_destroy(cs_);
+    }
+    cs_ = cairo_surface_create_similar_image(target, format, width, height);
+    cr_ = cairo_create(cs_);
+  }
+  return cr_;
+}
+
+void UprightFrame::end(cairo_surface_t* target) {
+  cairo_surface_flush(cs_);
+  cairo_surface_flush(target);
+  const int width = cairo_image_surface_get_width(cs_);
+  const int height = cairo_image_surface_get_height(cs_);
+  if (is_32_bit(cairo_image_surface_get_format(cs_))) {
+    rotateCounterclockwise32(
+        cairo_image_surface_get_data(cs_), cairo_image_surface_get_stride(cs_),
+        cairo_image_surface_get_data(target), cairo_image_surface_get_stride(target),
+        width, height);
+  } else {
+    rotateCounterclockwise16(
+        cairo_image_surface_get_data(cs_), cairo_image_surface_get_stride(cs_),
+        cairo_image_surface_get_data(target), cairo_image_surface_get_stride(target),
+        width, height);
+  }
+  cairo_surface_mark_dirty(target);
+}
+
+}  // namespace airball
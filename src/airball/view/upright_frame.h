@@ -0,0 +1,51 @@
+#ifndef AIRBALL_VIEW_UPRIGHT_FRAME_H
+#define AIRBALL_VIEW_UPRIGHT_FRAME_H
+
+#include <cairo/cairo.h>
+
+namespace airball {
+
+/**
+ * An offscreen image into which a frame for a display mounted sideways is
+ * drawn upright, so that drawing keeps the fast paths Cairo has for shapes
+ * and text aligned with the pixel grid. The finished frame is then turned a
+ * quarter turn into the screen by a plain copy of the pixels.
+ */
+class UprightFrame {
+public:
+  UprightFrame();
+  ~UprightFrame();
+
+  UprightFrame(const UprightFrame&) = delete;
+  UprightFrame& operator=(const UprightFrame&) = delete;
+
+  /**
+   * Whether frames for the given screen can be drawn upright.
+   *
+   * @param target the surface of the screen.
+   * @param width the width of the upright frame, which is the height of the
+   *     screen.
+   * @param height the height of the upright frame, which is the width of the
+   *     screen.
+   */
+  static bool supports(cairo_surface_t* target, int width, int height);
+
+  /**
+   * Begin drawing a frame. Unlike a CachedLayer, the image is not cleared,
+   * so the frame must cover all of it.
+   *
+   * @return a Cairo context for drawing into the frame.
+   */
+  cairo_t* begin(cairo_surface_t* target, int width, int height);
+
+  // Turn the frame counterclockwise into the target.
+  void end(cairo_surface_t* target);
+
+private:
+  cairo_surface_t* cs_;
+  cairo_t* cr_;
+};
+
+}  // namespace airball
+
+#endif  // AIRBALL_VIEW_UPRIGHT_FRAME_H
@@ -3,9 +3,23 @@
 #include <math.h>
 #include <cairo/cairo.h>
 #include <iostream>
+#include <map>
+#include <mutex>
+
+#include "rgb565_raster.h"
 
 namespace airball {
 
+static RenderBackend backend = RenderBackend::CAIRO;
+
+void set_render_backend(RenderBackend b) {
+  backend = b;
+}
+
+RenderBackend render_backend() {
+  return backend;
+}
+
 void Color::apply(cairo_t *cr) const {
   cairo_set_source_rgba(cr, r_, g_, b_, a_);
 }
@@ -16,13 +30,100 @@ void Stroke::apply(cairo_t *cr) const {
   color_.apply(cr);
 }
 
+// Font faces and scaled fonts, shared by every Font and never freed. Text is
+// drawn from more than one thread, so the caches are guarded by a mutex.
+class FontCache {
+public:
+  static FontCache& instance() {
+    static FontCache* cache = new FontCache();
+    return *cache;
+  }
+
+  cairo_font_face_t* face(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = faces_.find(name);
+    if (it == faces_.end()) {
+      it = faces_.emplace(
+          name,
+          cairo_toy_font_face_create(
+              name.c_str(),
+              CAIRO_FONT_SLANT_NORMAL,
+              CAIRO_FONT_WEIGHT_BOLD)).first;
+    }
+    return it->second;
+  }
+
+  // A scaled font for drawing the face at the given size into the context,
+  // with its current transformation and its target's font options.
+  cairo_scaled_font_t* scaled(cairo_t* cr, cairo_font_face_t* face, double size) {
+    cairo_matrix_t ctm;
+    cairo_get_matrix(cr, &ctm);
+    // Scaled fonts ignore translation.
+    ctm.x0 = 0;
+    ctm.y0 = 0;
+    cairo_font_options_t* options = cairo_font_options_create();
+    cairo_surface_get_font_options(cairo_get_target(cr), options);
+
+    std::lock_guard<std::mutex> lock(mu_);
+    for (const auto& s : scaled_) {
+      if (s.face == face && s.size == size &&
+          s.ctm.xx == ctm.xx && s.ctm.yx == ctm.yx &&
+          s.ctm.xy == ctm.xy && s.ctm.yy == ctm.yy &&
+          cairo_font_options_equal(s.options, options)) {
+        cairo_font_options_destroy(options);
+        return s.font;
+      }
+    }
+    cairo_matrix_t font_matrix;
+    cairo_matrix_init_scale(&font_matrix, size, size);
+    cairo_scaled_font_t* font =
+        cairo_scaled_font_create(face, &font_matrix, &ctm, options);
+    scaled_.push_back({face, size, ctm, options, font});
+    return font;
+  }
+
+private:
+  struct Scaled {
+    cairo_font_face_t* face;
+    double size;
+    cairo_matrix_t ctm;
+    cairo_font_options_t* options;
+    cairo_scaled_font_t* font;
+  };
+
+  std::mutex mu_;
+  std::map<std::string, cairo_font_face_t*> faces_;
+  std::vector<Scaled> scaled_;
+};
+
+Font::Font(
+    const std::string& face,
+    const double size)
+    : face_(face),
+      size_(size),
+      font_face_(FontCache::instance().face(face)) {}
+
 void Font::apply(cairo_t *cr) const {
-  cairo_select_font_face(
-      cr,
-      face().c_str(),
-      CAIRO_FONT_SLANT_NORMAL,
-      CAIRO_FONT_WEIGHT_BOLD);
-  cairo_set_font_size(cr, size_);
+  // The context keeps its font across calls, so often there is nothing to do.
+  if (cairo_get_font_face(cr) == font_face_) {
+    cairo_matrix_t m;
+    cairo_get_font_matrix(cr, &m);
+    if (m.xx == size_ && m.yy == size_ && m.xy == 0 && m.yx == 0) {
+      return;
+    }
+  }
+  cairo_set_scaled_font(cr, FontCache::instance().scaled(cr, font_face_, size_));
+}
+
+void Font::warm(cairo_t *cr) const {
+  static const char* kPrintable =
+      " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+      "[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+  cairo_save(cr);
+  apply(cr);
+  cairo_text_extents_t extents;
+  cairo_text_extents(cr, kPrintable, &extents);
+  cairo_restore(cr);
 }
 
 std::ostream&
@@ -61,6 +162,9 @@ void line(
     const Point& end,
     const Stroke& stroke) {
   // std::cout << "line(" << start << "," << end << "," << stroke << ")" << std::endl;
+  if (backend == RenderBackend::RGB565 && rgb565::line(cr, start, end, stroke)) {
+    return;
+  }
   cairo_move_to(cr, start.x(), start.y());
   cairo_line_to(cr, end.x(), end.y());
   stroke.apply(cr);
@@ -75,6 +179,10 @@ void arc(
     const double end_angle,
     const Stroke& stroke) {
   // std::cout << "arc(" << center << "," << radius << "," << start_angle << "," << end_angle << ")" << std::endl;
+  if (backend == RenderBackend::RGB565 &&
+      rgb565::arc(cr, center, radius, start_angle, end_angle, stroke)) {
+    return;
+  }
   cairo_new_path(cr);
   cairo_arc(cr,
             center.x(),
@@ -92,6 +200,9 @@ void disc(
     const double radius,
     const Color& fill) {
   // std::cout << "disc(" << center << "," << radius << "," << fill << ")" << std::endl;
+  if (backend == RenderBackend::RGB565 && rgb565::disc(cr, center, radius, fill)) {
+    return;
+  }
   cairo_arc(cr,
             center.x(),
             center.y(),
@@ -111,15 +222,32 @@ void rosette(
     const double start_angle,
     const Stroke& stroke) {
   double angle_increment = 2 * M_PI / ((double) num_petals);
+  if (backend == RenderBackend::RGB565) {
+    for (int i = 0; i < num_petals; i++) {
+      double angle = start_angle + i * angle_increment;
+      arc(cr,
+          center,
+          radius,
+          angle - petal_half_angle,
+          angle + petal_half_angle,
+          stroke);
+    }
+    return;
+  }
+  // The petals are stroked together, as one path.
+  cairo_new_path(cr);
   for (int i = 0; i < num_petals; i++) {
     double angle = start_angle + i * angle_increment;
-    arc(cr,
-        center,
-        radius,
-        angle - petal_half_angle,
-        angle + petal_half_angle,
-        stroke);
+    cairo_new_sub_path(cr);
+    cairo_arc(cr,
+              center.x(),
+              center.y(),
+              radius,
+              angle - petal_half_angle,
+              angle + petal_half_angle);
   }
+  stroke.apply(cr);
+  cairo_stroke(cr);
 }
 
 void rectangle(
@@ -128,6 +256,9 @@ void rectangle(
     const Size& size,
     const Color& fill) {
   // std::cout << "rectangle(" << top_left << "," << size << "," << fill << ")" << std::endl;
+  if (backend == RenderBackend::RGB565 && rgb565::rectangle(cr, top_left, size, fill)) {
+    return;
+  }
   cairo_rectangle(
       cr,
       top_left.x(),
@@ -233,6 +364,9 @@ void shape(
     const int numCorners,
     const Point corners[],
     const Color& fill) {
+  if (backend == RenderBackend::RGB565 && rgb565::shape(cr, numCorners, corners, fill)) {
+    return;
+  }
   cairo_move_to(
       cr,
       corners[0].x(),
@@ -260,55 +394,52 @@ Size text_size(
 
 static constexpr double kUppercaseVerticalOffsetRatio = 0.375;
 
-void draw_text(
-    cairo_t* cr,
-    const std::string& str,
+Point text_origin(
     const Point& point,
     const TextReferencePoint ref,
     const Font& font,
-    const Color& color) {
-  // std::cout << "text(\"" << str << "\"," << point << "," << ref << "," << font << "," << color << ")" << std::endl;
-  font.apply(cr);
-  color.apply(cr);
+    const Size& size) {
   switch (ref) {
     case TOP_LEFT:
-      cairo_move_to(
-          cr,
+      return {
           point.x(),
-          point.y() + font.size());
-      break;
+          point.y() + font.size()};
     case CENTER_LEFT_UPPERCASE:
-      cairo_move_to(
-          cr,
+      return {
           point.x(),
-          point.y() + kUppercaseVerticalOffsetRatio * font.size());
-      break;
+          point.y() + kUppercaseVerticalOffsetRatio * font.size()};
     case TOP_RIGHT:
+      return {
+          point.x() - size.w(),
+          point.y() + font.size()};
     case CENTER_RIGHT_UPPERCASE:
+      return {
+          point.x() - size.w(),
+          point.y() + kUppercaseVerticalOffsetRatio * font.size()};
     case CENTER_MID_UPPERCASE:
-      Size size = text_size(cr, str, font);
-      switch (ref) {
-        case TOP_RIGHT:
-          cairo_move_to(
-              cr,
-              point.x() - size.w(),
-              point.y() + font.size());
-          break;
-        case CENTER_RIGHT_UPPERCASE:
-          cairo_move_to(
-              cr,
-              point.x() - size.w(),
-              point.y() + kUppercaseVerticalOffsetRatio * font.size());
-          break;
-        case CENTER_MID_UPPERCASE:
-          cairo_move_to(
-              cr,
-              point.x() - size.w() / 2,
-              point.y() + kUppercaseVerticalOffsetRatio * font.size());
-          break;
-      }
-      break;
+      return {
+          point.x() - size.w() / 2,
+          point.y() + kUppercaseVerticalOffsetRatio * font.size()};
   }
+  return point;
+}
+
+void draw_text(
+    cairo_t* cr,
+    const std::string& str,
+    const Point& point,
+    const TextReferencePoint ref,
+    const Font& font,
+    const Color& color) {
+  // std::cout << "text(\"" << str << "\"," << point << "," << ref << "," << font << "," << color << ")" << std::endl;
+  font.apply(cr);
+  color.apply(cr);
+  const Size size =
+      (ref == TOP_LEFT || ref == CENTER_LEFT_UPPERCASE)
+      ? Size()
+      : text_size(cr, str, font);
+  const Point origin = text_origin(point, ref, font, size);
+  cairo_move_to(cr, origin.x(), origin.y());
   cairo_show_text(cr, str.c_str());
 }
 
@@ -68,19 +68,25 @@ private:
   double width_;
 };
 
+// A bold font of a given face and size. The face is looked up once, when
+// the Font is made, and the scaled fonts made from it are kept for as long
+// as the process runs, so applying a Font to a context is cheap.
 class Font {
 public:
   Font() : Font("", 0) {}
   Font(
       const std::string& face,
-      const double size)
-      : face_(face), size_(size) {}
+      const double size);
   const std::string& face() const { return face_; }
   double size() const { return size_; }
   void apply(cairo_t* cr) const;
+  // Load the font for drawing into the given context, and the metrics of
+  // its printable ASCII glyphs, so that the first text drawn is not slow.
+  void warm(cairo_t* cr) const;
 private:
   std::string face_;
   double size_;
+  cairo_font_face_t* font_face_;
 };
 
 std::ostream&
@@ -98,6 +104,23 @@ operator<<(std::ostream& os, const Stroke& s);
 std::ostream&
 operator<<(std::ostream& os, const Font& f);
 
+// How the primitives below are drawn.
+enum class RenderBackend {
+  // Everything is drawn with Cairo.
+  CAIRO,
+  // line(), arc(), disc(), rosette(), rectangle() and shape() draw straight
+  // into RGB565 image surfaces where they can, and with Cairo otherwise.
+  // With the view's caches on, that is what is drawn afresh in each frame
+  // onto an RGB565 screen, or into the opaque layers made like it. The
+  // transparent overlay and the sprites are ARGB32, so they are always drawn
+  // with Cairo, but only when they are rebuilt.
+  RGB565,
+};
+
+void set_render_backend(RenderBackend backend);
+
+RenderBackend render_backend();
+
 void line(
     cairo_t* cr,
     const Point& start,
@@ -171,6 +194,15 @@ Size text_size(
     const std::string& str,
     const Font& font);
 
+// The origin of the first glyph of text, such that the reference point of
+// text with the given size lies at the given point. The size is not used for
+// the TOP_LEFT and CENTER_LEFT_UPPERCASE reference points.
+Point text_origin(
+    const Point& point,
+    const TextReferencePoint ref,
+    const Font& font,
+    const Size& size);
+
 void draw_text(
     cairo_t* cr,
     const std::string& str,
@@ -0,0 +1,174 @@
+// Compares the speed and output of the Cairo and RGB565 widget backends.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+
+#include "widgets.h"
+
+DEFINE_int32(iterations, 500, "Number of times to draw each test");
+DEFINE_int32(width, 240, "Width of the surface");
+DEFINE_int32(height, 320, "Height of the surface");
+DEFINE_bool(write_png, false, "Write the output of each backend to a PNG file");
+
+namespace airball {
+
+struct Test {
+  std::string name;
+  std::function<void(cairo_t*)> draw;
+};
+
+static const Color kBackground(0, 0, 0);
+static const Color kWhite(255, 255, 255);
+static const Color kMagenta(255, 0, 255);
+static const Color kTranslucent = Color(0, 180, 180).with_alpha(0.5);
+
+std::vector<Test> tests() {
+  const double w = FLAGS_width;
+  const double h = FLAGS_height;
+  const Point c(w / 2, h / 2);
+  return {
+      {"disc", [=](cairo_t* cr) {
+        disc(cr, c, w / 8, kWhite);
+        disc(cr, Point(w / 3, h / 3), w / 20, kTranslucent);
+        disc(cr, Point(2 * w / 3, 2 * h / 3), 3.3, kMagenta);
+      }},
+      {"line", [=](cairo_t* cr) {
+        for (int i = 0; i < 16; i++) {
+          const double a = i * M_PI / 8 + 0.1;
+          line(
+              cr,
+              c,
+              Point(c.x() + w / 2 * cos(a), c.y() + w / 2 * sin(a)),
+              Stroke(kWhite, 2 + i % 3));
+        }
+      }},
+      {"rosette", [=](cairo_t* cr) {
+        rosette(cr, c, w / 3, 4, 35.0 / 180 * M_PI, M_PI / 4, Stroke(kMagenta, 3));
+        rosette(cr, c, w / 4, 2, 7.5 / 180 * M_PI, 0, Stroke(kWhite, 4));
+      }},
+      {"rectangle", [=](cairo_t* cr) {
+        rectangle(cr, Point(0, 0), Size(w, h), kBackground);
+        rectangle(cr, Point(10.5, 20.25), Size(w / 2, 40.5), kTranslucent);
+        rectangle(cr, Point(5, h - 45), Size(w - 10, 40), kWhite);
+      }},
+      {"shape", [=](cairo_t* cr) {
+        const Point corners[] = {
+            Point(w * 0.1, h * 0.8),
+            Point(w * 0.5, h * 0.55),
+            Point(w * 0.9, h * 0.8),
+            Point(w * 0.5, h * 0.7),
+        };
+        shape(cr, 4, corners, kMagenta);
+      }},
+  };
+}
+
+double time_test(cairo_t* cr, const Test& t) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iterations; i++) {
+    t.draw(cr);
+  }
+  cairo_surface_flush(cairo_get_target(cr));
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() / FLAGS_iterations;
+}
+
+void draw_all(cairo_t* cr, const std::vector<Test>& ts) {
+  for (const auto& t : ts) {
+    t.draw(cr);
+  }
+  cairo_surface_flush(cairo_get_target(cr));
+}
+
+// The mean and maximum absolute difference, per channel, in 8 bit units.
+void compare(cairo_surface_t* a, cairo_surface_t* b, double& mean, int& max) {
+  const int stride = cairo_image_surface_get_stride(a);
+  const unsigned char* da = cairo_image_surface_get_data(a);
+  const unsigned char* db = cairo_image_surface_get_data(b);
+  long total = 0;
+  max = 0;
+  for (int y = 0; y < FLAGS_height; y++) {
+    const auto* ra = (const uint16_t*) (da + y * stride);
+    const auto* rb = (const uint16_t*) (db + y * stride);
+    for (int x = 0; x < FLAGS_width; x++) {
+      const int channels[][2] = {
+          {(ra[x] >> 11) << 3, (rb[x] >> 11) << 3},
+          {((ra[x] >> 5) & 0x3f) << 2, ((rb[x] >> 5) & 0x3f) << 2},
+          {(ra[x] & 0x1f) << 3, (rb[x] & 0x1f) << 3},
+      };
+      for (const auto& ch : channels) {
+        const int d = abs(ch[0] - ch[1]);
+        total += d;
+        max = std::max(max, d);
+      }
+    }
+  }
+  mean = (double) total / (FLAGS_width * FLAGS_height * 3);
+}
+
+int bench() {
+  cairo_surface_t* cs[2];
+  cairo_t* cr[2];
+  const RenderBackend backends[] = {RenderBackend::CAIRO, RenderBackend::RGB565};
+  const char* names[] = {"cairo", "rgb565"};
+  for (int i = 0; i < 2; i++) {
+    cs[i] = cairo_image_surface_create(CAIRO_FORMAT_RGB16_565, FLAGS_width, FLAGS_height);
+    cr[i] = cairo_create(cs[i]);
+  }
+
+  const auto ts = tests();
+  std::cout << std::left << std::setw(12) << "test"
+            << std::right << std::setw(12) << "cairo us"
+            << std::setw(12) << "rgb565 us"
+            << std::setw(10) << "speedup" << std::endl;
+  for (const auto& t : ts) {
+    double us[2];
+    for (int i = 0; i < 2; i++) {
+      set_render_backend(backends[i]);
+      us[i] = time_test(cr[i], t);
+    }
+    std::cout << std::left << std::setw(12) << t.name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << us[0]
+              << std::setw(12) << us[1]
+              << std::setw(9) << us[0] / us[1] << "x" << std::endl;
+  }
+
+  // Draw the same scene with each backend and compare the results.
+  for (int i = 0; i < 2; i++) {
+    set_render_backend(backends[i]);
+    rectangle(cr[i], Point(0, 0), Size(FLAGS_width, FLAGS_height), kBackground);
+    draw_all(cr[i], ts);
+    if (FLAGS_write_png) {
+      std::string file_name = std::string("widgets_bench_") + names[i] + ".png";
+      cairo_surface_write_to_png(cs[i], file_name.c_str());
+    }
+  }
+  double mean;
+  int max;
+  compare(cs[0], cs[1], mean, max);
+  std::cout << "difference: mean " << std::setprecision(3) << mean
+            << ", max " << max << std::endl;
+
+  for (int i = 0; i < 2; i++) {
+    cairo_destroy(cr[i]);
+    cairo_surface_destroy(cs[i]);
+  }
+  return 0;
+}
+
+}  // namespace airball
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  return airball::bench();
+}
@@ -1,25 +1,38 @@
 #ifndef AIRBALL_FRAMEWORK_APPLICATION_H
 #define AIRBALL_FRAMEWORK_APPLICATION_H
 
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <utility>
 
 #include "IScreen.h"
 #include "IView.h"
 #include "ISoundScheme.h"
 #include "IEventQueue.h"
+#include "FrameStats.h"
+#include "QualityGovernor.h"
+#include "StageTimers.h"
 
 namespace airball {
 
+// The Model must provide a version(), of any type that can be compared for
+// equality, that changes whenever anything the view depends on changes. Frames
+// are only painted when the version differs from that of the last frame
+// painted.
 template <typename Model>
 class Application {
 public:
   Application()
-      : running_(true) {
-    eventQueue_.reset(new EventQueueImpl(&eventsMu_, &events_));
+      : running_(true),
+        painted_(false),
+        paintedVersion_(),
+        governor_(nullptr) {
+    eventQueue_.reset(new EventQueueImpl(&eventsMu_, &eventsCv_, &events_));
   }
 
   virtual ~Application() = default;
@@ -31,27 +44,68 @@ public:
 
   void run() {
     initialize();
+#ifdef AIRBALL_STAGE_TIMING
+    StageTimers::instance().dump_on_signal(SIGUSR1);
+#endif
     soundScheme_->install(soundMixer_.get());
+    bool idle = false;
     while (running()) {
       std::vector<std::function<void()>> currentEvents;
       {
-        std::lock_guard<std::mutex> lock(eventsMu_);
+        std::unique_lock<std::mutex> lock(eventsMu_);
+        if (idle) {
+          // Nothing changed last time around, so rather than spinning, wait
+          // for an event. The timeout lets changes that happen without an
+          // event, like airdata expiring, still be noticed.
+          eventsCv_.wait_for(lock, kIdleInterval, [this]() {
+            return !events_.empty();
+          });
+        }
         currentEvents = std::move(events_);
       }
+      frameStats_.record_events(currentEvents.size());
       for (const auto & event : currentEvents) {
         event();
       }
-      view_->paint(*model_, screen_.get());
-      screen_->flush();
+      const auto version = model_->version();
+      if (!painted_ || version != paintedVersion_) {
+        const auto start = std::chrono::steady_clock::now();
+        {
+          AIRBALL_TIME_STAGE("paint");
+          view_->paint(*model_, screen_.get());
+        }
+        const auto painted = std::chrono::steady_clock::now();
+        {
+          AIRBALL_TIME_STAGE("screen_flush");
+          screen_->flush();
+        }
+        const auto flushed = std::chrono::steady_clock::now();
+        frameStats_.record_frame(painted - start, flushed - painted);
+        if (governor_ != nullptr) {
+          governor_->record(flushed - start);
+        }
+        AIRBALL_STAGE_TIMING_POLL();
+        painted_ = true;
+        paintedVersion_ = version;
+        idle = false;
+      } else {
+        idle = true;
+      }
       soundScheme_->update(*model_, soundMixer_.get());
+      frameStats_.set_xruns(soundMixer_->xruns());
+      frameStats_.set_bytes_transferred(screen_->bytes_transferred());
+      frameStats_.poll();
       std::this_thread::sleep_for(frameInterval_);
     }
     soundScheme_->remove(soundMixer_.get());
   }
 
   void stop() {
-    std::lock_guard<std::mutex> lock(runningMu_);
-    running_ = false;
+    {
+      std::lock_guard<std::mutex> lock(runningMu_);
+      running_ = false;
+    }
+    eventsCv_.notify_all();
   }
 
 protected:
@@ -68,24 +122,38 @@ protected:
 
   void setFrameInterval(std::chrono::duration<double, std::milli> i) { frameInterval_ = i; }
 
+  // If set, told how long each frame took to paint and flush. Not owned.
+  void setQualityGovernor(QualityGovernor* g) { governor_ = g; }
+
   IEventQueue* eventQueue() { return eventQueue_.get(); }
 
+  // Counts of what the loop does, for display.
+  FrameStats* frameStats() { return &frameStats_; }
+
   virtual void initialize() = 0;
 
 private:
+  // The longest the loop waits for an event when there is nothing to paint.
+  static constexpr std::chrono::milliseconds kIdleInterval{10};
+
   class EventQueueImpl : public IEventQueue {
   public:
     EventQueueImpl(std::mutex* mu,
+                   std::condition_variable* cv,
                    std::vector<std::function<void()>>* q)
-        : mu_(mu), q_(q) {}
+        : mu_(mu), cv_(cv), q_(q) {}
 
     void enqueue(std::function<void()> event) override {
-      std::lock_guard<std::mutex> lock(*mu_);
-      q_->push_back(event);
+      {
+        std::lock_guard<std::mutex> lock(*mu_);
+        q_->push_back(event);
+      }
+      cv_->notify_one();
     }
 
   private:
     std::mutex* mu_;
+    std::condition_variable* cv_;
     std::vector<std::function<void()>>* q_;
   };
 
@@ -101,10 +169,18 @@ private:
   std::unique_ptr<IEventQueue> eventQueue_;
 
   std::mutex eventsMu_;
+  std::condition_variable eventsCv_;
   std::vector<std::function<void()>> events_;
 
   std::mutex runningMu_;
   bool running_;
+
+  bool painted_;
+  decltype(std::declval<const Model&>().version()) paintedVersion_;
+
+  QualityGovernor* governor_;
+
+  FrameStats frameStats_;
 };
 
 } // namespace airball
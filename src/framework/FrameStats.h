@@ -0,0 +1,114 @@
+#ifndef AIRBALL_FRAMEWORK_FRAME_STATS_H
+#define AIRBALL_FRAMEWORK_FRAME_STATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace airball {
+
+// Counts of what the application does in each frame, summarized once per
+// interval so that they can be displayed without changing in every frame.
+//
+// Everything but count_telemetry() is called from the application's loop, and
+// the summary is only read from that thread, as by the view while painting.
+class FrameStats {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr std::chrono::seconds kInterval{1};
+
+  struct Summary {
+    // Changes with each new summary.
+    unsigned long sequence = 0;
+    // Frames painted per second.
+    double fps = 0;
+    // The mean time to paint a frame and to flush it to the screen.
+    double paint_ms = 0;
+    double flush_ms = 0;
+    // Telemetry packets received per second.
+    double telemetry_per_second = 0;
+    // The most events waiting to be run at the start of any frame.
+    size_t event_queue_depth = 0;
+    // The number of times the sound output has run dry, in total.
+    unsigned long xruns = 0;
+    // The mean number of bytes of pixel data sent to the display per frame,
+    // or 0 if the screen does not count them.
+    double bytes_per_frame = 0;
+  };
+
+  FrameStats()
+      : telemetry_(0),
+        start_(Clock::now()) {}
+
+  void record_frame(Clock::duration paint, Clock::duration flush) {
+    frames_++;
+    paint_ += paint;
+    flush_ += flush;
+  }
+
+  void record_events(size_t queued) {
+    event_queue_depth_ = std::max(event_queue_depth_, queued);
+  }
+
+  void set_xruns(unsigned long xruns) {
+    summary_.xruns = xruns;
+  }
+
+  void set_bytes_transferred(uint64_t bytes) {
+    bytes_transferred_ = bytes;
+  }
+
+  // Count a packet of telemetry. May be called from any thread.
+  void count_telemetry() {
+    telemetry_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Start a new summary if one is due. Call this from somewhere that runs
+  // regularly, like the end of each frame.
+  void poll() {
+    const auto now = Clock::now();
+    const auto elapsed = now - start_;
+    if (elapsed < kInterval) {
+      return;
+    }
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    summary_.sequence++;
+    summary_.fps = frames_ / seconds;
+    summary_.paint_ms = frames_ == 0 ? 0 : ms(paint_) / frames_;
+    summary_.flush_ms = frames_ == 0 ? 0 : ms(flush_) / frames_;
+    summary_.telemetry_per_second =
+        telemetry_.exchange(0, std::memory_order_relaxed) / seconds;
+    summary_.event_queue_depth = event_queue_depth_;
+    summary_.bytes_per_frame = frames_ == 0 ? 0 :
+        (double) (bytes_transferred_ - bytes_at_start_) / frames_;
+    bytes_at_start_ = bytes_transferred_;
+    start_ = now;
+    frames_ = 0;
+    paint_ = flush_ = Clock::duration::zero();
+    event_queue_depth_ = 0;
+  }
+
+  const Summary& summary() const { return summary_; }
+
+private:
+  static double ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  }
+
+  Summary summary_;
+  std::atomic<unsigned long> telemetry_;
+  Clock::time_point start_;
+  unsigned long frames_ = 0;
+  Clock::duration paint_ = Clock::duration::zero();
+  Clock::duration flush_ = Clock::duration::zero();
+  size_t event_queue_depth_ = 0;
+  uint64_t bytes_transferred_ = 0;
+  uint64_t bytes_at_start_ = 0;
+};
+
+} // namespace airball
+
+#endif // AIRBALL_FRAMEWORK_FRAME_STATS_H
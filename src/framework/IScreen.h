@@ -2,6 +2,7 @@
 #define AIRBALL_FRAMEWORK_I_SCREEN_H
 
 #include <cairo/cairo.h>
+#include <cstdint>
 
 namespace airball {
 
@@ -11,17 +12,26 @@ namespace airball {
  */
 class IScreen {
 public:
+  virtual ~IScreen() = default;
+
   // Return a Cairo context allowing an application to draw to the Screen.
   virtual cairo_t *cr() const = 0;
 
   // Return a Cairo surface corresponding to the context cr().
   virtual cairo_surface_t *cs() const = 0;
 
-  // Indicate to this Screen that the current image is to be flushed.
+  // Indicate to this Screen that the current image is to be flushed. The
+  // Screen may present the image asynchronously, and may switch cr() and cs()
+  // to a different image whose contents are undefined, so the application
+  // must draw every pixel of each frame and fetch cr() and cs() anew.
   virtual void flush() = 0;
 
   // Set the brightness of this screen, from 0.0 (dark) to 1.0 (fully bright).
   virtual void setBrightness(double value) = 0;
+
+  // The number of bytes of pixel data sent to the display since startup, or
+  // 0 if this Screen does not count them.
+  virtual uint64_t bytes_transferred() const { return 0; }
 };
 
 } // namespace airball
@@ -27,6 +27,9 @@ public:
 
   virtual snd_pcm_uframes_t octaves_to_period(double base_cycles_per_second,
                                               double octaves) = 0;
+
+  // The number of times the output has run dry and been restarted.
+  virtual unsigned long xruns() const = 0;
 };
 
 } // namespace airball
@@ -0,0 +1,101 @@
+#ifndef AIRBALL_FRAMEWORK_QUALITY_GOVERNOR_H
+#define AIRBALL_FRAMEWORK_QUALITY_GOVERNOR_H
+
+#include <algorithm>
+#include <chrono>
+
+namespace airball {
+
+// Trades the quality of what is drawn for keeping up the frame rate.
+//
+// The time taken to paint and flush each frame is compared with a budget.
+// When several frames in a row overrun it, the governor steps down a tier,
+// and the view leaves out more ornament. When frames have been comfortably
+// within the budget for a good while, it steps back up. Tier 0 is full
+// quality; what each further tier leaves out is up to the view.
+//
+// If a step up is soon followed by a step down, the governor waits twice as
+// long before trying the next step up, so that it does not keep bouncing
+// between two tiers.
+class QualityGovernor {
+public:
+  using Duration = std::chrono::duration<double, std::milli>;
+
+  // Frames in a row over budget that cause a step down.
+  static constexpr int kOverrunsToStepDown = 3;
+  // Frames in a row within kHeadroom of the budget that cause a step up,
+  // before any backing off.
+  static constexpr int kQuietFramesToStepUp = 120;
+  // The fraction of the budget a frame must be within to count as quiet.
+  static constexpr double kHeadroom = 0.6;
+  // The most the wait before a step up is multiplied by backing off.
+  static constexpr int kMaxBackoff = 32;
+
+  // A budget of zero turns the governor off, leaving it at tier 0.
+  QualityGovernor(Duration budget, int max_tier)
+      : budget_(budget),
+        max_tier_(max_tier),
+        tier_(0),
+        overruns_(0),
+        quiet_(0),
+        backoff_(1),
+        frames_since_step_up_(-1) {}
+
+  Duration budget() const { return budget_; }
+  int tier() const { return tier_; }
+
+  // Record how long a frame took to paint and flush.
+  void record(Duration frame_time) {
+    if (budget_.count() <= 0) {
+      return;
+    }
+    if (frames_since_step_up_ >= 0) {
+      frames_since_step_up_++;
+    }
+    if (frame_time > budget_) {
+      quiet_ = 0;
+      if (++overruns_ >= kOverrunsToStepDown && tier_ < max_tier_) {
+        stepDown();
+      }
+      return;
+    }
+    overruns_ = 0;
+    if (frame_time > budget_ * kHeadroom) {
+      quiet_ = 0;
+      return;
+    }
+    if (++quiet_ >= kQuietFramesToStepUp * backoff_ && tier_ > 0) {
+      tier_--;
+      quiet_ = 0;
+      frames_since_step_up_ = 0;
+    }
+  }
+
+private:
+  void stepDown() {
+    // A step down soon after a step up means the step up was premature.
+    if (frames_since_step_up_ >= 0 &&
+        frames_since_step_up_ < kQuietFramesToStepUp * backoff_) {
+      backoff_ = std::min(backoff_ * 2, kMaxBackoff);
+    } else {
+      backoff_ = 1;
+    }
+    tier_++;
+    overruns_ = 0;
+    frames_since_step_up_ = -1;
+  }
+
+  const Duration budget_;
+  const int max_tier_;
+  int tier_;
+  int overruns_;
+  int quiet_;
+  int backoff_;
+  // Frames since the last step up, or -1 if there has been a step down
+  // since.
+  int frames_since_step_up_;
+};
+
+} // namespace airball
+
+#endif // AIRBALL_FRAMEWORK_QUALITY_GOVERNOR_H
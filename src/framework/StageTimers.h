@@ -0,0 +1,192 @@
+#ifndef AIRBALL_FRAMEWORK_STAGE_TIMERS_H
+#define AIRBALL_FRAMEWORK_STAGE_TIMERS_H
+
+// Optional timing of the stages of painting and presenting frames.
+//
+// Code marks a stage by placing AIRBALL_TIME_STAGE("name") at the start of
+// a scope, which times the rest of the scope. Times are accumulated into a
+// histogram per stage. The histograms are printed to std::cerr when the
+// process receives SIGUSR1 or, if a dump interval is set, periodically, at
+// the next call to AIRBALL_STAGE_TIMING_POLL().
+//
+// Unless AIRBALL_STAGE_TIMING is defined, the macros expand to nothing.
+
+#ifdef AIRBALL_STAGE_TIMING
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+namespace airball {
+
+class StageTimers {
+public:
+  // The most stages that can be timed. Further stages are ignored.
+  static constexpr int kMaxStages = 32;
+  // Bucket i holds times of at least 2^(i-1) and less than 2^i microseconds,
+  // except that the last bucket also holds everything longer.
+  static constexpr int kBuckets = 24;
+
+  static StageTimers& instance() {
+    static StageTimers timers;
+    return timers;
+  }
+
+  // Returns the index of the stage with the given name, adding it if needed.
+  int stage(const char* name) {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (int i = 0; i < num_stages_; i++) {
+      if (stages_[i].name == name) {
+        return i;
+      }
+    }
+    if (num_stages_ == kMaxStages) {
+      return -1;
+    }
+    stages_[num_stages_].name = name;
+    return num_stages_++;
+  }
+
+  void record(int stage, std::chrono::steady_clock::duration d) {
+    if (stage < 0) {
+      return;
+    }
+    const auto us = (unsigned long)
+        std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    int bucket = 0;
+    while (bucket < kBuckets - 1 && (1ul << bucket) <= us) {
+      bucket++;
+    }
+    Stage& s = stages_[stage];
+    s.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    s.count.fetch_add(1, std::memory_order_relaxed);
+    s.total_us.fetch_add(us, std::memory_order_relaxed);
+    unsigned long max = s.max_us.load(std::memory_order_relaxed);
+    while (us > max &&
+           !s.max_us.compare_exchange_weak(max, us, std::memory_order_relaxed)) {}
+  }
+
+  // Print the histograms on receipt of the given signal.
+  void dump_on_signal(int signum) {
+    std::signal(signum, [](int) {
+      instance().dump_requested_.store(true, std::memory_order_relaxed);
+    });
+  }
+
+  // Print the histograms every so often. Zero means never.
+  void set_dump_interval(std::chrono::steady_clock::duration interval) {
+    dump_interval_ = interval;
+    last_dump_ = std::chrono::steady_clock::now();
+  }
+
+  // Print the histograms if that has been asked for, or is due. Call this
+  // from somewhere that runs regularly, like the end of each frame.
+  void poll() {
+    const auto now = std::chrono::steady_clock::now();
+    const bool due =
+        dump_interval_.count() > 0 && now - last_dump_ >= dump_interval_;
+    if (due || dump_requested_.exchange(false, std::memory_order_relaxed)) {
+      last_dump_ = now;
+      dump(std::cerr);
+    }
+  }
+
+  void dump(std::ostream& os) {
+    std::lock_guard<std::mutex> lock(mu_);
+    os << std::left << std::setw(20) << "stage"
+       << std::right << std::setw(10) << "count"
+       << std::setw(10) << "mean us"
+       << std::setw(10) << "p50 us"
+       << std::setw(10) << "p99 us"
+       << std::setw(10) << "max us" << std::endl;
+    for (int i = 0; i < num_stages_; i++) {
+      const Stage& s = stages_[i];
+      const unsigned long count = s.count.load(std::memory_order_relaxed);
+      if (count == 0) {
+        continue;
+      }
+      os << std::left << std::setw(20) << s.name
+         << std::right << std::setw(10) << count
+         << std::setw(10) << s.total_us.load(std::memory_order_relaxed) / count
+         << std::setw(10) << percentile(s, count, 0.50)
+         << std::setw(10) << percentile(s, count, 0.99)
+         << std::setw(10) << s.max_us.load(std::memory_order_relaxed)
+         << std::endl;
+    }
+  }
+
+private:
+  struct Stage {
+    std::string name;
+    std::atomic<unsigned long> buckets[kBuckets] = {};
+    std::atomic<unsigned long> count = 0;
+    std::atomic<unsigned long> total_us = 0;
+    std::atomic<unsigned long> max_us = 0;
+  };
+
+  StageTimers() : num_stages_(0), dump_requested_(false), dump_interval_(0) {}
+
+  // The upper bound of the bucket holding the given fraction of the times,
+  // which is within a factor of two of the true value.
+  static unsigned long percentile(const Stage& s, unsigned long count, double p) {
+    const auto target = (unsigned long) (p * count);
+    const unsigned long max = s.max_us.load(std::memory_order_relaxed);
+    unsigned long seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+      seen += s.buckets[i].load(std::memory_order_relaxed);
+      if (seen > target) {
+        return std::min(1ul << i, max);
+      }
+    }
+    return max;
+  }
+
+  std::mutex mu_;
+  Stage stages_[kMaxStages];
+  int num_stages_;
+  std::atomic<bool> dump_requested_;
+  std::chrono::steady_clock::duration dump_interval_;
+  std::chrono::steady_clock::time_point last_dump_;
+};
+
+// Records the time from its construction to its destruction.
+class StageTimer {
+public:
+  explicit StageTimer(int stage)
+      : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+  ~StageTimer() {
+    StageTimers::instance().record(stage_, std::chrono::steady_clock::now() - start_);
+  }
+
+private:
+  const int stage_;
+  const std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace airball
+
+#define AIRBALL_STAGE_TIMER_CONCAT2(a, b) a##b
+#define AIRBALL_STAGE_TIMER_CONCAT(a, b) AIRBALL_STAGE_TIMER_CONCAT2(a, b)
+
+#define AIRBALL_TIME_STAGE(name) \
+  static const int AIRBALL_STAGE_TIMER_CONCAT(airball_stage_, __LINE__) = \
+      ::airball::StageTimers::instance().stage(name); \
+  ::airball::StageTimer AIRBALL_STAGE_TIMER_CONCAT(airball_stage_timer_, __LINE__)( \
+      AIRBALL_STAGE_TIMER_CONCAT(airball_stage_, __LINE__))
+
+#define AIRBALL_STAGE_TIMING_POLL() ::airball::StageTimers::instance().poll()
+
+#else
+
+#define AIRBALL_TIME_STAGE(name)
+#define AIRBALL_STAGE_TIMING_POLL()
+
+#endif // AIRBALL_STAGE_TIMING
+
+#endif // AIRBALL_FRAMEWORK_STAGE_TIMERS_H
@@ -0,0 +1,62 @@
+#include <iostream>
+
+#include "QualityGovernor.h"
+
+#define ASSERT_TRUE(x) if (!(x)) { std::cout << "Assertion failed " << __FILE__ << ":" << __LINE__ << std::endl; }
+
+using airball::QualityGovernor;
+
+void run(QualityGovernor& g, int frames, double ms) {
+  for (int i = 0; i < frames; i++) {
+    g.record(QualityGovernor::Duration(ms));
+  }
+}
+
+int main(int arg, char** argv) {
+  {
+    // Off, whatever happens.
+    QualityGovernor g(QualityGovernor::Duration(0), 4);
+    run(g, 100, 1000);
+    ASSERT_TRUE(g.tier() == 0);
+  }
+
+  {
+    QualityGovernor g(QualityGovernor::Duration(10), 4);
+
+    // A single slow frame is tolerated.
+    run(g, 1, 20);
+    run(g, 1, 5);
+    ASSERT_TRUE(g.tier() == 0);
+
+    // A run of them steps down, one tier per run, no further than the last.
+    run(g, QualityGovernor::kOverrunsToStepDown, 20);
+    ASSERT_TRUE(g.tier() == 1);
+    run(g, QualityGovernor::kOverrunsToStepDown * 10, 20);
+    ASSERT_TRUE(g.tier() == 4);
+
+    // Frames within budget but without headroom do not step up.
+    run(g, QualityGovernor::kQuietFramesToStepUp * 2, 9);
+    ASSERT_TRUE(g.tier() == 4);
+
+    // Quiet frames do, after a while.
+    run(g, QualityGovernor::kQuietFramesToStepUp - 1, 2);
+    ASSERT_TRUE(g.tier() == 4);
+    run(g, 1, 2);
+    ASSERT_TRUE(g.tier() == 3);
+
+    // Stepping straight back down makes the next step up wait longer.
+    run(g, QualityGovernor::kOverrunsToStepDown, 20);
+    ASSERT_TRUE(g.tier() == 4);
+    run(g, QualityGovernor::kQuietFramesToStepUp, 2);
+    ASSERT_TRUE(g.tier() == 4);
+    run(g, QualityGovernor::kQuietFramesToStepUp, 2);
+    ASSERT_TRUE(g.tier() == 3);
+
+    // But staying up for long enough forgives that.
+    run(g, QualityGovernor::kQuietFramesToStepUp * 2, 9);
+    run(g, QualityGovernor::kOverrunsToStepDown, 20);
+    ASSERT_TRUE(g.tier() == 4);
+    run(g, QualityGovernor::kQuietFramesToStepUp, 2);
+    ASSERT_TRUE(g.tier() == 3);
+  }
+}